@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "CodepointSet.h"
+
+App::CodepointSet::CodepointSet()
+	: m_pageSlots(PageCount, NoPage)
+	, m_pageRanks(PageCount + 1) {}
+
+bool App::CodepointSet::Contains(char32_t c) const {
+	if (c > 0x10FFFF || m_pageSlots[c >> PageBits] == NoPage)
+		return false;
+
+	const auto& page = m_pages[m_pageSlots[c >> PageBits]];
+	const auto offset = c & (CodepointsPerPage - 1);
+	return (page[offset / 64] >> (offset % 64)) & 1;
+}
+
+size_t App::CodepointSet::Count() const {
+	return m_pageRanks.back();
+}
+
+size_t App::CodepointSet::Count(char32_t c1, char32_t c2) const {
+	if (c1 > c2)
+		return 0;
+	return Rank(c2 >= 0x10FFFF ? 0x110000 : c2 + 1) - Rank(c1);
+}
+
+bool App::CodepointSet::IsEmpty() const {
+	return m_pageRanks.back() == 0;
+}
+
+void App::CodepointSet::Insert(char32_t c) {
+	if (c > 0x10FFFF)
+		return;
+
+	auto& slot = m_pageSlots[c >> PageBits];
+	if (slot == NoPage) {
+		slot = static_cast<uint16_t>(m_pages.size());
+		m_pages.emplace_back();
+	}
+
+	const auto offset = c & (CodepointsPerPage - 1);
+	m_pages[slot][offset / 64] |= uint64_t{ 1 } << (offset % 64);
+}
+
+void App::CodepointSet::UpdateRanks() {
+	uint32_t rank = 0;
+	for (size_t i = 0; i < PageCount; i++) {
+		m_pageRanks[i] = rank;
+		if (m_pageSlots[i] != NoPage) {
+			for (const auto word : m_pages[m_pageSlots[i]])
+				rank += static_cast<uint32_t>(std::popcount(word));
+		}
+	}
+	m_pageRanks[PageCount] = rank;
+}
+
+size_t App::CodepointSet::Rank(char32_t c) const {
+	if (c > 0x10FFFF)
+		return m_pageRanks.back();
+
+	const auto pageIndex = c >> PageBits;
+	size_t rank = m_pageRanks[pageIndex];
+	if (m_pageSlots[pageIndex] == NoPage)
+		return rank;
+
+	const auto& page = m_pages[m_pageSlots[pageIndex]];
+	const auto offset = c & (CodepointsPerPage - 1);
+	for (size_t i = 0; i < offset / 64; i++)
+		rank += std::popcount(page[i]);
+	if (const auto bits = offset % 64)
+		rank += std::popcount(page[offset / 64] & ((uint64_t{ 1 } << bits) - 1));
+	return rank;
+}
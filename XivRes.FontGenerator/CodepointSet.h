@@ -0,0 +1,76 @@
+#pragma once
+
+namespace App {
+	// Immutable set of Unicode codepoints, stored as 256-codepoint bitmap pages with running counts,
+	// so that counting the codepoints in a range takes constant time regardless of the range size.
+	class CodepointSet {
+		static constexpr size_t PageBits = 8;
+		static constexpr size_t CodepointsPerPage = size_t{ 1 } << PageBits;
+		static constexpr size_t WordsPerPage = CodepointsPerPage / 64;
+		static constexpr size_t PageCount = (0x10FFFF >> PageBits) + 1;
+		static constexpr uint16_t NoPage = UINT16_MAX;
+
+		using Page = std::array<uint64_t, WordsPerPage>;
+
+		// Index into m_pages for each page, or NoPage if the page has no codepoints.
+		std::vector<uint16_t> m_pageSlots;
+
+		// Number of codepoints before each page; has one more item at the end for the total.
+		std::vector<uint32_t> m_pageRanks;
+
+		std::vector<Page> m_pages;
+
+	public:
+		CodepointSet();
+
+		template<std::ranges::input_range R>
+		explicit CodepointSet(const R& codepoints)
+			: CodepointSet() {
+			for (const auto c : codepoints)
+				Insert(static_cast<char32_t>(c));
+			UpdateRanks();
+		}
+
+		[[nodiscard]] bool Contains(char32_t c) const;
+
+		[[nodiscard]] size_t Count() const;
+
+		// Count the codepoints in [c1, c2].
+		[[nodiscard]] size_t Count(char32_t c1, char32_t c2) const;
+
+		[[nodiscard]] bool IsEmpty() const;
+
+		// Call fn with each codepoint in [c1, c2] in ascending order, until fn returns false.
+		template<typename TFn>
+		void ForEach(char32_t c1, char32_t c2, TFn&& fn) const {
+			if (c2 > 0x10FFFF)
+				c2 = 0x10FFFF;
+			if (c1 > c2)
+				return;
+
+			for (auto pageIndex = c1 >> PageBits; pageIndex <= (c2 >> PageBits); pageIndex++) {
+				if (m_pageSlots[pageIndex] == NoPage)
+					continue;
+
+				const auto& page = m_pages[m_pageSlots[pageIndex]];
+				for (size_t wordIndex = 0; wordIndex < WordsPerPage; wordIndex++) {
+					for (auto word = page[wordIndex]; word; word &= word - 1) {
+						const auto c = static_cast<char32_t>((pageIndex << PageBits) + wordIndex * 64 + std::countr_zero(word));
+						if (c < c1)
+							continue;
+						if (c > c2 || !fn(c))
+							return;
+					}
+				}
+			}
+		}
+
+	private:
+		void Insert(char32_t c);
+
+		void UpdateRanks();
+
+		// Count the codepoints less than c.
+		[[nodiscard]] size_t Rank(char32_t c) const;
+	};
+}
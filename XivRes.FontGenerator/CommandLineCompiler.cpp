@@ -0,0 +1,699 @@
+#include "pch.h"
+#include "CommandLineCompiler.h"
+#include "FontDataCache.h"
+#include "FontGeneratorConfig.h"
+#include "MappedFileStream.h"
+#include "resource.h"
+
+static std::atomic_bool s_bCancelRequested = false;
+
+// Quote an argument so that CommandLineToArgvW gives it back as it is.
+static std::wstring QuoteArgument(const std::wstring& arg) {
+	if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos)
+		return arg;
+
+	std::wstring res = L"\"";
+	for (auto it = arg.begin();; ++it) {
+		size_t nBackslashes = 0;
+		for (; it != arg.end() && *it == L'\\'; ++it)
+			nBackslashes++;
+
+		if (it == arg.end()) {
+			res.append(nBackslashes * 2, L'\\');
+			break;
+		}
+
+		if (*it == L'"')
+			res.append(nBackslashes * 2 + 1, L'\\');
+		else
+			res.append(nBackslashes, L'\\');
+		res.push_back(*it);
+	}
+	res.push_back(L'"');
+	return res;
+}
+
+static uint64_t GetPeakWorkingSetSize(HANDLE hProcess) {
+	PROCESS_MEMORY_COUNTERS pmc{};
+	if (!GetProcessMemoryInfo(hProcess, &pmc, sizeof pmc))
+		return 0;
+	return pmc.PeakWorkingSetSize;
+}
+
+static BOOL WINAPI ConsoleCtrlHandler(DWORD dwCtrlType) {
+	switch (dwCtrlType) {
+		case CTRL_C_EVENT:
+		case CTRL_BREAK_EVENT:
+			s_bCancelRequested = true;
+			return TRUE;
+	}
+	return FALSE;
+}
+
+App::ConsoleProgress::ConsoleProgress() {
+	SetConsoleCtrlHandler(&ConsoleCtrlHandler, TRUE);
+}
+
+App::ConsoleProgress::~ConsoleProgress() {
+	SetConsoleCtrlHandler(&ConsoleCtrlHandler, FALSE);
+}
+
+void App::ConsoleProgress::ThrowIfCancelled() const {
+	if (s_bCancelRequested)
+		throw CancelledError();
+}
+
+bool App::ConsoleProgress::IsCancelled() const {
+	return s_bCancelRequested;
+}
+
+void App::ConsoleProgress::UpdateStatusMessage(std::wstring_view s) {
+	const auto lock = std::lock_guard(m_mtx);
+	if (m_lastStatus == s)
+		return;
+
+	const auto now = clock::now();
+	const auto elapsed = std::chrono::duration<double>(now - m_begin).count();
+	if (m_lastStatus.empty()) {
+		WriteLine(std::format("[{:9.3f}s] {}", elapsed, xivres::util::unicode::convert<std::string>(s)));
+	} else {
+		const auto stage = std::chrono::duration<double>(now - m_stageBegin).count();
+		WriteLine(std::format("[{:9.3f}s] {} (previous step took {:.3f}s)", elapsed, xivres::util::unicode::convert<std::string>(s), stage));
+	}
+
+	m_lastStatus = s;
+	m_stageBegin = now;
+	m_nLastProgressStep = -1;
+}
+
+void App::ConsoleProgress::UpdateProgress(float progress) {
+	if (std::isnan(progress))
+		return;
+
+	const auto lock = std::lock_guard(m_mtx);
+	const auto step = static_cast<int>(std::clamp(progress, 0.f, 1.f) * 10);
+	if (step <= m_nLastProgressStep)
+		return;
+
+	m_nLastProgressStep = step;
+	const auto elapsed = std::chrono::duration<double>(clock::now() - m_begin).count();
+	WriteLine(std::format("[{:9.3f}s]   {:3}%", elapsed, step * 10));
+}
+
+std::chrono::milliseconds App::ConsoleProgress::Finish() {
+	const auto lock = std::lock_guard(m_mtx);
+	const auto now = clock::now();
+	const auto elapsed = std::chrono::duration<double>(now - m_begin).count();
+	const auto stage = std::chrono::duration<double>(now - m_stageBegin).count();
+	WriteLine(std::format("[{:9.3f}s] Done (previous step took {:.3f}s)", elapsed, stage));
+	m_lastStatus.clear();
+	m_stageBegin = now;
+	return std::chrono::duration_cast<std::chrono::milliseconds>(now - m_begin);
+}
+
+void App::ConsoleProgress::WriteLine(std::string_view line) const {
+	std::fwrite(line.data(), 1, line.size(), stdout);
+	std::fputc('\n', stdout);
+	std::fflush(stdout);
+}
+
+App::CommandLineCompiler::CommandLineCompiler(std::vector<std::wstring> args)
+	: m_args(std::move(args)) {}
+
+bool App::CommandLineCompiler::IsRequested(const std::vector<std::wstring>& args) {
+	return std::ranges::any_of(args, [](const auto& arg) { return arg == L"--compile" || arg == L"--benchmark"; });
+}
+
+void App::CommandLineCompiler::PrepareConsole(bool bHasConsole) {
+	// Standard handles of a console program may be redirected to a pipe or a file, and must be left as they are.
+	if (!bHasConsole) {
+		if (!AttachConsole(ATTACH_PARENT_PROCESS))
+			AllocConsole();
+
+		FILE* fp;
+		freopen_s(&fp, "CONOUT$", "w", stdout);
+		freopen_s(&fp, "CONOUT$", "w", stderr);
+	}
+	SetConsoleOutputCP(CP_UTF8);
+
+	SetHeadlessErrorReporting(true);
+}
+
+void App::CommandLineCompiler::ParseArguments() {
+	enum class Target {
+		None,
+		Compile,
+		Ttmp,
+		Raw,
+		Compression,
+		Threads,
+		Trace,
+		Stats,
+		Substitutions,
+		Benchmark,
+		Output,
+	} target = Target::None;
+
+	// First argument is the program path.
+	for (size_t i = 1; i < m_args.size(); i++) {
+		const auto& arg = m_args[i];
+		if (arg == L"--compile") {
+			target = Target::Compile;
+		} else if (arg == L"--ttmp") {
+			target = Target::Ttmp;
+		} else if (arg == L"--raw") {
+			target = Target::Raw;
+		} else if (arg == L"--compression") {
+			target = Target::Compression;
+		} else if (arg == L"--threads") {
+			target = Target::Threads;
+		} else if (arg == L"--trace") {
+			target = Target::Trace;
+		} else if (arg == L"--stats") {
+			target = Target::Stats;
+		} else if (arg == L"--substitutions") {
+			target = Target::Substitutions;
+		} else if (arg == L"--benchmark") {
+			target = Target::Benchmark;
+		} else if (arg == L"--output") {
+			target = Target::Output;
+		} else if (arg == L"--no-cache") {
+			m_bNoCache = true;
+		} else if (arg == L"--reproducible") {
+			g_config.ReproducibleExports = true;
+		} else if (arg == L"--check-reproducible") {
+			g_config.ReproducibleExports = true;
+			m_bCheckReproducible = true;
+		} else if (arg == L"--optimize-layout") {
+			m_bOptimizeLayout = true;
+		} else if (arg.starts_with(L"--")) {
+			throw std::invalid_argument(std::format("Unknown option: {}", xivres::util::unicode::convert<std::string>(arg)));
+		} else {
+			switch (target) {
+				case Target::Compile:
+					m_presets.emplace_back(arg);
+					break;
+
+				case Target::Ttmp:
+					m_ttmpDir = arg;
+					target = Target::None;
+					break;
+
+				case Target::Raw:
+					m_rawDir = arg;
+					target = Target::None;
+					break;
+
+				case Target::Compression:
+					if (arg == L"while")
+						m_compressionMode = FontSetExporter::CompressionMode::CompressWhilePacking;
+					else if (arg == L"after")
+						m_compressionMode = FontSetExporter::CompressionMode::CompressAfterPacking;
+					else if (arg == L"none")
+						m_compressionMode = FontSetExporter::CompressionMode::DoNotCompress;
+					else
+						throw std::invalid_argument(std::format("Unknown compression mode: {}", xivres::util::unicode::convert<std::string>(arg)));
+					target = Target::None;
+					break;
+
+				case Target::Threads:
+					g_config.WorkerThreads = std::stoul(arg);
+					target = Target::None;
+					break;
+
+				case Target::Trace:
+					m_tracePath = arg;
+					target = Target::None;
+					break;
+
+				case Target::Stats:
+					m_statsPath = arg;
+					target = Target::None;
+					break;
+
+				case Target::Substitutions:
+					m_substitutionsPath = arg;
+					target = Target::None;
+					break;
+
+				case Target::Benchmark:
+					m_benchmarkDir = arg;
+					target = Target::None;
+					break;
+
+				case Target::Output:
+					m_benchmarkOutputPath = arg;
+					target = Target::None;
+					break;
+
+				default:
+					throw std::invalid_argument(std::format("Unexpected argument: {}", xivres::util::unicode::convert<std::string>(arg)));
+			}
+		}
+	}
+
+	if (target != Target::None && target != Target::Compile)
+		throw std::invalid_argument("Option is missing its value");
+	if (m_presets.empty() && !m_benchmarkDir)
+		throw std::invalid_argument("No preset file specified");
+	if (!m_presets.empty() && m_benchmarkDir)
+		throw std::invalid_argument("--compile and --benchmark cannot be used together");
+	if (m_bCheckReproducible && (m_benchmarkDir || (!m_ttmpDir && !m_rawDir)))
+		throw std::invalid_argument("--check-reproducible needs --compile with --ttmp or --raw");
+
+	if (m_bNoCache) {
+		g_config.UseGlyphCache = false;
+		g_config.UseCompiledFontSetCache = false;
+	}
+
+	if (m_substitutionsPath) {
+		std::ifstream in(*m_substitutionsPath);
+		if (!in)
+			throw std::invalid_argument(std::format("Failed to open {}", xivres::util::unicode::convert<std::string>(m_substitutionsPath->wstring())));
+
+		nlohmann::json j;
+		in >> j;
+		m_substitutions = j.get<std::map<std::string, std::string>>();
+	}
+}
+
+void App::CommandLineCompiler::PrintUsage() {
+	std::fputs(
+		"Usage: XivRes.FontGenerator.exe --compile <preset.json> [<preset.json> ...]\n"
+		"                                [--ttmp <directory>] [--raw <directory>]\n"
+		"                                [--compression while|after|none] [--threads <count>]\n"
+		"                                [--trace <trace.json>] [--stats <stats.json>]\n"
+		"                                [--substitutions <substitutions.json>] [--no-cache]\n"
+		"                                [--optimize-layout] [--reproducible] [--check-reproducible]\n"
+		"       XivRes.FontGenerator.exe --benchmark <preset directory> [--output <results.json>]\n"
+		"                                [--substitutions <substitutions.json>] [--threads <count>]\n"
+		"                                [--ttmp <directory>] [--raw <directory>] [--compression while|after|none]\n"
+		"\n"
+		"  --ttmp         Write <directory>/<preset name>.ttmp2 for each preset.\n"
+		"  --raw          Write .fdt and .tex files into <directory>/<preset name>/ for each preset.\n"
+		"  --compression  Compression mode for TTMP2 output. Defaults to \"while\".\n"
+		"  --threads      Number of worker threads. Defaults to \"workerThreads\" in config.json,\n"
+		"                 or the number of hardware threads if that is 0.\n"
+		"  --trace        Write the time taken by each step as a Chrome trace (chrome://tracing, Perfetto),\n"
+		"                 and print a summary table when done.\n"
+		"  --stats        Write the time taken by each step, glyph, kerning pair and texture counts,\n"
+		"                 how much of the textures is used, and peak memory usage as JSON.\n"
+		"  --substitutions\n"
+		"                 JSON object mapping font family names to the ones to use instead, such as\n"
+		"                 Benchmarks/FontSubstitutions.json.\n"
+		"  --no-cache     Do not use or update the glyph and compiled FontSet caches.\n"
+		"  --optimize-layout\n"
+		"                 Before exporting, try compiling each FontSet with several texture side lengths and\n"
+		"                 discard steps, and use the one taking the least texture memory within the number of\n"
+		"                 textures the game can load. The preset file is left unchanged.\n"
+		"  --reproducible Make TTMP2 output byte-identical across runs given the same presets and fonts,\n"
+		"                 by listing files in a fixed order and clearing zip timestamps.\n"
+		"  --check-reproducible\n"
+		"                 Implies --reproducible. Export each preset once more into a temporary directory,\n"
+		"                 compiling again without any cache, and fail if any file differs. Glyphs drawn from\n"
+		"                 the glyph cache in the first export are thereby checked against the fonts themselves.\n"
+		"  --benchmark    Compile each preset in the directory in a separate process without caches,\n"
+		"                 and write the stats of all of them into --output (benchmark.json by default).\n"
+		"\n"
+		"If neither --ttmp nor --raw is given, presets are only compiled to check for errors.\n"
+		"Use the console build (XivRes.FontGenerator.Cli) from scripts; shells do not wait for the GUI build\n"
+		"to exit, nor can its output be redirected.\n",
+		stderr);
+}
+
+int App::CommandLineCompiler::Run() {
+	try {
+		ParseArguments();
+	} catch (const std::logic_error& e) {
+		std::fprintf(stderr, "%s\n\n", e.what());
+		PrintUsage();
+		return 2;
+	}
+
+	if (m_benchmarkDir)
+		return RunBenchmark();
+
+	std::shared_ptr<TraceRecorder> trace;
+	if (m_tracePath || m_statsPath)
+		trace = std::make_shared<TraceRecorder>();
+
+	const auto begin = std::chrono::steady_clock::now();
+	auto presetStats = nlohmann::json::array();
+	FontSetExporter::Statistics statistics;
+
+	auto nFailures = 0;
+	for (const auto& presetPath : m_presets) {
+		const auto presetName = presetPath.stem();
+		std::printf("%s\n", xivres::util::unicode::convert<std::string>(presetPath.wstring()).c_str());
+
+		const auto presetNameU8 = xivres::util::unicode::convert<std::string>(presetName.wstring());
+		const auto presetTrace = TraceRecorder::Scope(trace.get(), "Preset", "preset", nlohmann::json::object({{"preset", presetNameU8}}));
+		const auto presetBegin = std::chrono::steady_clock::now();
+		auto& stats = presetStats.emplace_back(nlohmann::json::object({{"preset", presetNameU8}, {"succeeded", false}}));
+		try {
+			Structs::MultiFontSet multiFontSet;
+			{
+				std::ifstream in(presetPath);
+				if (!in)
+					throw std::runtime_error(std::format("Failed to open {}", xivres::util::unicode::convert<std::string>(presetPath.wstring())));
+
+				nlohmann::json j;
+				in >> j;
+				multiFontSet = j.get<Structs::MultiFontSet>();
+			}
+			ApplySubstitutions(multiFontSet);
+
+			ConsoleProgress progress;
+			FontSetExporter exporter(multiFontSet, progress);
+			exporter.SetTraceRecorder(trace);
+
+			if (m_bOptimizeLayout)
+				OptimizeLayouts(exporter, multiFontSet);
+
+			if (m_ttmpDir) {
+				create_directories(*m_ttmpDir);
+				exporter.ExportToTTMP(*m_ttmpDir / (std::filesystem::path(presetName) += L".ttmp2"), m_compressionMode);
+			}
+
+			if (m_rawDir) {
+				const auto basePath = *m_rawDir / presetName;
+				create_directories(basePath);
+				exporter.ExportToRaw(basePath);
+			}
+
+			if (!m_ttmpDir && !m_rawDir) {
+				for (const auto& pFontSet : multiFontSet.FontSets)
+					exporter.Compile(*pFontSet);
+			}
+
+			progress.Finish();
+
+			if (m_bCheckReproducible) {
+				const auto bReproducible = CheckReproducible(multiFontSet, presetName);
+				stats["reproducible"] = bReproducible;
+				if (!bReproducible)
+					nFailures++;
+			}
+
+			const auto presetStatistics = exporter.GetStatistics();
+			statistics.GlyphCount += presetStatistics.GlyphCount;
+			statistics.KerningPairCount += presetStatistics.KerningPairCount;
+			statistics.TextureCount += presetStatistics.TextureCount;
+			statistics.UsedTextureCount += presetStatistics.UsedTextureCount;
+			stats["succeeded"] = true;
+			stats["glyphs"] = presetStatistics.GlyphCount;
+			stats["kerningPairs"] = presetStatistics.KerningPairCount;
+			stats["textures"] = presetStatistics.TextureCount;
+			stats["usedTextures"] = presetStatistics.UsedTextureCount;
+			stats["milliseconds"] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - presetBegin).count();
+
+			if (presetStatistics.TextureCount) {
+				std::printf("Textures: %zu, of which %.2f used (%.1f%%)\n",
+					presetStatistics.TextureCount,
+					presetStatistics.UsedTextureCount,
+					100. * presetStatistics.UsedTextureCount / static_cast<double>(presetStatistics.TextureCount));
+			}
+
+			if (exporter.IsExpectedTexCountChanged() && !m_bOptimizeLayout)
+				std::printf("Note: expected texture count differs from the preset; save it from the editor to update.\n");
+		} catch (const ConsoleProgress::CancelledError&) {
+			std::fputs("Cancelled.\n", stderr);
+			return 1;
+		} catch (const WException& e) {
+			ShowErrorMessageBox(nullptr, IDS_ERROR_EXPORTFAILURE_BODY, e);
+			nFailures++;
+		} catch (const std::system_error& e) {
+			ShowErrorMessageBox(nullptr, IDS_ERROR_EXPORTFAILURE_BODY, e);
+			nFailures++;
+		} catch (const std::exception& e) {
+			ShowErrorMessageBox(nullptr, IDS_ERROR_EXPORTFAILURE_BODY, e);
+			nFailures++;
+		}
+	}
+
+	if (m_tracePath) {
+		try {
+			trace->WriteChromeTrace(*m_tracePath);
+		} catch (const std::exception& e) {
+			ShowErrorMessageBox(nullptr, IDS_ERROR_EXPORTFAILURE_BODY, e);
+			nFailures++;
+		}
+		std::printf("\n%s", trace->GetSummary().c_str());
+	}
+
+	if (m_statsPath) {
+		auto stages = nlohmann::json::array();
+		for (const auto& row : trace->Summarize()) {
+			stages.emplace_back(nlohmann::json::object({
+				{"name", row.Name},
+				{"count", row.Count},
+				{"totalMilliseconds", row.TotalMilliseconds},
+				{"maxMilliseconds", row.MaxMilliseconds},
+			}));
+		}
+
+		const auto j = nlohmann::json::object({
+			{"presets", std::move(presetStats)},
+			{"stages", std::move(stages)},
+			{"glyphs", statistics.GlyphCount},
+			{"kerningPairs", statistics.KerningPairCount},
+			{"textures", statistics.TextureCount},
+			{"usedTextures", statistics.UsedTextureCount},
+			{"milliseconds", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count()},
+			{"peakWorkingSetBytes", GetPeakWorkingSetSize(GetCurrentProcess())},
+		});
+
+		if (std::ofstream out(*m_statsPath); out) {
+			out << j.dump(1, '\t');
+		} else {
+			std::fprintf(stderr, "Failed to write %s\n", xivres::util::unicode::convert<std::string>(m_statsPath->wstring()).c_str());
+			nFailures++;
+		}
+	}
+
+	return nFailures ? 1 : 0;
+}
+
+void App::CommandLineCompiler::ApplySubstitutions(Structs::MultiFontSet& multiFontSet) const {
+	if (m_substitutions.empty())
+		return;
+
+	for (const auto& pFontSet : multiFontSet.FontSets) {
+		for (const auto& pFace : pFontSet->Faces) {
+			for (const auto& pElem : pFace->Elements) {
+				if (pElem->Renderer != Structs::RendererEnum::DirectWrite && pElem->Renderer != Structs::RendererEnum::FreeType)
+					continue;
+
+				if (const auto it = m_substitutions.find(pElem->Lookup.Name); it != m_substitutions.end())
+					pElem->Lookup.Name = it->second;
+			}
+		}
+	}
+}
+
+bool App::CommandLineCompiler::CheckReproducible(const Structs::MultiFontSet& multiFontSet, const std::filesystem::path& presetName) const {
+	// Make a copy with no fonts loaded yet, keeping the layouts chosen by --optimize-layout if any.
+	auto multiFontSetCopy = nlohmann::json(multiFontSet).get<Structs::MultiFontSet>();
+
+	// Render every glyph again too, so that glyphs drawn from the glyph cache get compared against the fonts themselves.
+	const auto bUseGlyphCache = g_config.UseGlyphCache;
+	const auto bUseCompiledFontSetCache = g_config.UseCompiledFontSetCache;
+	g_config.UseGlyphCache = false;
+	g_config.UseCompiledFontSetCache = false;
+	const auto restoreConfig = xivres::util::on_dtor([bUseGlyphCache, bUseCompiledFontSetCache]() {
+		g_config.UseGlyphCache = bUseGlyphCache;
+		g_config.UseCompiledFontSetCache = bUseCompiledFontSetCache;
+	});
+
+	const auto tempDir = std::filesystem::temp_directory_path() / std::format(L"XivRes.FontGenerator.{}", GetCurrentProcessId());
+	const auto removeTempDir = xivres::util::on_dtor([&tempDir]() {
+		std::error_code ec;
+		std::filesystem::remove_all(tempDir, ec);
+	});
+
+	auto bSame = true;
+	const auto compare = [&bSame](const std::filesystem::path& first, const std::filesystem::path& second) {
+		if (!exists(first) || !exists(second)) {
+			std::printf("%s: exported only once\n", xivres::util::unicode::convert<std::string>(first.wstring()).c_str());
+			bSame = false;
+			return;
+		}
+
+		const auto firstHash = FontDataCache::Hash(MappedFileStream(first));
+		const auto secondHash = FontDataCache::Hash(MappedFileStream(second));
+		if (firstHash != secondHash) {
+			std::printf("%s: %016llX, exported again as %016llX\n",
+				xivres::util::unicode::convert<std::string>(first.wstring()).c_str(),
+				static_cast<unsigned long long>(firstHash),
+				static_cast<unsigned long long>(secondHash));
+			bSame = false;
+		}
+	};
+
+	ConsoleProgress progress;
+	FontSetExporter exporter(multiFontSetCopy, progress);
+	create_directories(tempDir);
+
+	if (m_ttmpDir) {
+		const auto fileName = std::filesystem::path(presetName) += L".ttmp2";
+		exporter.ExportToTTMP(tempDir / fileName, m_compressionMode);
+		compare(*m_ttmpDir / fileName, tempDir / fileName);
+	}
+
+	if (m_rawDir) {
+		const auto firstPath = *m_rawDir / presetName;
+		const auto secondPath = tempDir / presetName;
+		create_directories(secondPath);
+		exporter.ExportToRaw(secondPath);
+
+		std::set<std::filesystem::path> relativePaths;
+		for (const auto& basePath : {firstPath, secondPath}) {
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(basePath)) {
+				if (entry.is_regular_file())
+					relativePaths.insert(entry.path().lexically_relative(basePath));
+			}
+		}
+		for (const auto& relativePath : relativePaths)
+			compare(firstPath / relativePath, secondPath / relativePath);
+	}
+
+	progress.Finish();
+
+	if (bSame)
+		std::printf("Exported again with the same result.\n");
+	return bSame;
+}
+
+void App::CommandLineCompiler::OptimizeLayouts(FontSetExporter& exporter, Structs::MultiFontSet& multiFontSet) {
+	for (const auto& pFontSet : multiFontSet.FontSets) {
+		const auto result = exporter.OptimizeLayout(*pFontSet);
+
+		std::printf("%s: up to %zu textures\n", pFontSet->TexFilenameFormat.c_str(), result.TextureCountLimit);
+		for (size_t i = 0; i < result.Trials.size(); i++) {
+			const auto& trial = result.Trials[i];
+			const auto mark = result.Chosen == i ? '*' : ' ';
+			if (trial.TextureCount) {
+				std::printf("  %c %4d / %d: %zu textures (%.2f used), %lld ms\n",
+					mark, trial.SideLength, trial.DiscardStep, trial.TextureCount, trial.UsedTextureCount, static_cast<long long>(trial.Duration.count()));
+			} else {
+				std::printf("  %c %4d / %d: failed: %s\n",
+					mark, trial.SideLength, trial.DiscardStep, xivres::util::unicode::convert<std::string>(trial.Error).c_str());
+			}
+		}
+
+		if (result.Chosen) {
+			std::printf("Using side length %d and discard step %d%s.\n",
+				pFontSet->SideLength, pFontSet->DiscardStep,
+				result.bChanged ? "; set them in the preset to keep using them" : "");
+		} else {
+			std::printf("No layout fits; keeping side length %d and discard step %d.\n", pFontSet->SideLength, pFontSet->DiscardStep);
+		}
+	}
+}
+
+int App::CommandLineCompiler::RunBenchmark() {
+	std::vector<std::filesystem::path> presets;
+	for (const auto& entry : std::filesystem::directory_iterator(*m_benchmarkDir)) {
+		if (entry.is_regular_file() && entry.path().extension() == L".json")
+			presets.emplace_back(entry.path());
+	}
+	std::ranges::sort(presets);
+
+	std::wstring exePath(PATHCCH_MAX_CCH + 1, L'\0');
+	exePath.resize(GetModuleFileNameW(nullptr, exePath.data(), static_cast<DWORD>(exePath.size())));
+
+	const auto statsPath = std::filesystem::temp_directory_path() / std::format(L"XivRes.FontGenerator.benchmark.{}.json", GetCurrentProcessId());
+	const auto threads = g_config.GetWorkerThreadCount();
+
+	// Keeps Ctrl+C from terminating this process, so that the results so far can be written after the current preset cancels.
+	ConsoleProgress progress;
+
+	auto results = nlohmann::json::array();
+	auto nFailures = 0;
+	for (const auto& presetPath : presets) {
+		if (progress.IsCancelled())
+			break;
+
+		std::printf("[benchmark %zu/%zu] ", results.size() + 1, presets.size());
+		std::fflush(stdout);
+
+		std::vector<std::wstring> childArgs{exePath, L"--compile", presetPath.wstring(), L"--no-cache", L"--stats", statsPath.wstring(), L"--threads", std::to_wstring(threads)};
+		if (m_substitutionsPath)
+			childArgs.insert(childArgs.end(), {L"--substitutions", m_substitutionsPath->wstring()});
+		if (m_ttmpDir)
+			childArgs.insert(childArgs.end(), {L"--ttmp", m_ttmpDir->wstring()});
+		if (m_rawDir)
+			childArgs.insert(childArgs.end(), {L"--raw", m_rawDir->wstring()});
+		switch (m_compressionMode) {
+			case FontSetExporter::CompressionMode::CompressWhilePacking:
+				childArgs.insert(childArgs.end(), {L"--compression", L"while"});
+				break;
+			case FontSetExporter::CompressionMode::CompressAfterPacking:
+				childArgs.insert(childArgs.end(), {L"--compression", L"after"});
+				break;
+			case FontSetExporter::CompressionMode::DoNotCompress:
+				childArgs.insert(childArgs.end(), {L"--compression", L"none"});
+				break;
+		}
+
+		std::wstring commandLine;
+		for (const auto& arg : childArgs) {
+			if (!commandLine.empty())
+				commandLine += L' ';
+			commandLine += QuoteArgument(arg);
+		}
+
+		std::filesystem::remove(statsPath);
+
+		STARTUPINFOW si{.cb = sizeof si};
+		PROCESS_INFORMATION pi{};
+		const auto begin = std::chrono::steady_clock::now();
+		if (!CreateProcessW(exePath.c_str(), commandLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi))
+			throw std::system_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()), "CreateProcessW");
+
+		const auto closeHandles = xivres::util::on_dtor([&pi]() {
+			CloseHandle(pi.hThread);
+			CloseHandle(pi.hProcess);
+		});
+
+		WaitForSingleObject(pi.hProcess, INFINITE);
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+		DWORD exitCode{};
+		GetExitCodeProcess(pi.hProcess, &exitCode);
+		if (exitCode)
+			nFailures++;
+
+		auto& result = results.emplace_back(nlohmann::json::object({
+			{"preset", xivres::util::unicode::convert<std::string>(presetPath.filename().wstring())},
+			{"exitCode", exitCode},
+			{"processMilliseconds", elapsed},
+			{"peakWorkingSetBytes", GetPeakWorkingSetSize(pi.hProcess)},
+		}));
+
+		if (std::ifstream in(statsPath); in) {
+			try {
+				result["stats"] = nlohmann::json::parse(in);
+			} catch (const nlohmann::json::exception&) {
+				// Process got terminated while writing; leave the stats out.
+			}
+		}
+	}
+	std::filesystem::remove(statsPath);
+
+	const auto outputPath = m_benchmarkOutputPath.value_or("benchmark.json");
+	std::ofstream out(outputPath);
+	if (!out) {
+		std::fprintf(stderr, "Failed to write %s\n", xivres::util::unicode::convert<std::string>(outputPath.wstring()).c_str());
+		return 1;
+	}
+
+	out << nlohmann::json::object({
+		{"threads", threads},
+		{"substitutions", m_substitutionsPath ? xivres::util::unicode::convert<std::string>(m_substitutionsPath->wstring()) : std::string()},
+		{"results", std::move(results)},
+	}).dump(1, '\t');
+
+	std::printf("Benchmark results written to %s\n", xivres::util::unicode::convert<std::string>(outputPath.wstring()).c_str());
+	return nFailures ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "FontSetExporter.h"
+
+namespace App {
+	class ConsoleProgress : public ExportProgress {
+		using clock = std::chrono::steady_clock;
+
+		mutable std::mutex m_mtx;
+		const clock::time_point m_begin = clock::now();
+		clock::time_point m_stageBegin = m_begin;
+		std::wstring m_lastStatus;
+		int m_nLastProgressStep = -1;
+
+	public:
+		class CancelledError : public std::runtime_error {
+		public:
+			CancelledError() : std::runtime_error("Cancelled by user") {}
+		};
+
+		ConsoleProgress();
+		~ConsoleProgress() override;
+
+		void ThrowIfCancelled() const override;
+
+		bool IsCancelled() const override;
+
+		void UpdateStatusMessage(std::wstring_view s) override;
+
+		void UpdateProgress(float progress) override;
+
+		// Prints the duration of the last stage, and returns the time elapsed since this object has been created.
+		std::chrono::milliseconds Finish();
+
+	private:
+		void WriteLine(std::string_view line) const;
+	};
+
+	class CommandLineCompiler {
+		const std::vector<std::wstring> m_args;
+
+		std::vector<std::filesystem::path> m_presets;
+		std::optional<std::filesystem::path> m_ttmpDir;
+		std::optional<std::filesystem::path> m_rawDir;
+		std::optional<std::filesystem::path> m_tracePath;
+		std::optional<std::filesystem::path> m_statsPath;
+		std::optional<std::filesystem::path> m_substitutionsPath;
+		std::optional<std::filesystem::path> m_benchmarkDir;
+		std::optional<std::filesystem::path> m_benchmarkOutputPath;
+		std::map<std::string, std::string> m_substitutions;
+		bool m_bNoCache = false;
+		bool m_bOptimizeLayout = false;
+		bool m_bCheckReproducible = false;
+		FontSetExporter::CompressionMode m_compressionMode = FontSetExporter::CompressionMode::CompressWhilePacking;
+
+	public:
+		CommandLineCompiler(std::vector<std::wstring> args);
+
+		// Test whether the program should run without any window.
+		static bool IsRequested(const std::vector<std::wstring>& args);
+
+		// Route error messages to the console; unless the program has been built as a console program,
+		// attach to the console of the parent process, or create a new one, first.
+		static void PrepareConsole(bool bHasConsole);
+
+		int Run();
+
+	private:
+		void ParseArguments();
+
+		static void PrintUsage();
+
+		// Replace font family names of DirectWrite and FreeType fonts as specified by --substitutions.
+		void ApplySubstitutions(Structs::MultiFontSet& multiFontSet) const;
+
+		// Compile every preset in the directory, each in its own process so that peak memory usage can be measured per preset.
+		int RunBenchmark();
+
+		// Export the presets again into a temporary directory, and compare the hashes of the files with the ones from the first export.
+		// FontSets are compiled again without any cache, so glyphs that the first export drew from the glyph cache are checked against the fonts.
+		bool CheckReproducible(const Structs::MultiFontSet& multiFontSet, const std::filesystem::path& presetName) const;
+
+		// Search for the best side length and discard step of every FontSet, and print what has been tried.
+		static void OptimizeLayouts(FontSetExporter& exporter, Structs::MultiFontSet& multiFontSet);
+	};
+}
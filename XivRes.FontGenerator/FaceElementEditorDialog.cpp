@@ -170,27 +170,11 @@ INT_PTR App::FaceElementEditorDialog::FontCombo_OnCommand(uint16_t notiCode) {
 		return 0;
 
 	if (m_element.Renderer == Structs::RendererEnum::DirectWrite || m_element.Renderer == Structs::RendererEnum::FreeType) {
-		IDWriteLocalizedStringsPtr names;
-		if (FAILED(m_fontFamilies[ComboBox_GetCurSel(m_controls->FontCombo)]->GetFamilyNames(&names)))
+		const auto curSel = ComboBox_GetCurSel(m_controls->FontCombo);
+		if (!m_fontCatalogue || curSel < 0 || static_cast<size_t>(curSel) >= m_fontCatalogue->GetFamilies().size())
 			return -1;
 
-		UINT32 index;
-		if (BOOL exists; FAILED(names->FindLocaleName(L"en-us", &index, &exists)) || !exists) {
-			if (FAILED(names->FindLocaleName(L"en", &index, &exists)) || !exists)
-				index = 0;
-		}
-
-		UINT32 length;
-		if (FAILED(names->GetStringLength(index, &length)))
-			return -1;
-
-		std::wstring name(length + 1, L'\0');
-		if (FAILED(names->GetString(index, name.data(), length + 1)))
-			return -1;
-
-		name.resize(length);
-
-		m_element.Lookup.Name = xivres::util::unicode::convert<std::string>(name);
+		m_element.Lookup.Name = xivres::util::unicode::convert<std::string>(m_fontCatalogue->GetFamilies()[curSel].EnglishName);
 	} else {
 		std::wstring name(ComboBox_GetTextLength(m_controls->FontCombo) + 1, L'\0');
 		name.resize(ComboBox_GetText(m_controls->FontCombo, name.data(), name.size()));
@@ -450,11 +434,11 @@ INT_PTR App::FaceElementEditorDialog::CustomRangeEdit_OnCommand(uint16_t notiCod
 }
 
 INT_PTR App::FaceElementEditorDialog::CustomRangeAdd_OnCommand(uint16_t notiCode) {
-	std::vector<char32_t> charVec(m_element.GetBaseFont()->all_codepoints().begin(), m_element.GetBaseFont()->all_codepoints().end());
+	const auto pFaceData = m_element.GetSharedFaceData();
 
 	auto changed = false;
 	for (const auto& [c1, c2] : ParseCustomRangeString())
-		changed |= AddNewCodepointRange(c1, c2, charVec);
+		changed |= AddNewCodepointRange(c1, c2, pFaceData->Codepoints);
 
 	if (changed)
 		OnWrappedFontChanged();
@@ -525,7 +509,7 @@ INT_PTR App::FaceElementEditorDialog::UnicodeBlockSearchResultList_OnCommand(uin
 
 		ListBox_GetSelItems(m_controls->UnicodeBlockSearchResultList, static_cast<int>(selItems.size()), selItems.data());
 
-		std::vector<char32_t> charVec(m_element.GetBaseFont()->all_codepoints().begin(), m_element.GetBaseFont()->all_codepoints().end());
+		const auto pFaceData = m_element.GetSharedFaceData();
 		std::wstring containingChars;
 
 		containingChars.reserve(8192);
@@ -533,11 +517,10 @@ INT_PTR App::FaceElementEditorDialog::UnicodeBlockSearchResultList_OnCommand(uin
 		for (const auto itemIndex : selItems) {
 			const auto& block = *reinterpret_cast<xivres::util::unicode::blocks::block_definition*>(ListBox_GetItemData(m_controls->UnicodeBlockSearchResultList, itemIndex));
 
-			for (auto it = std::ranges::lower_bound(charVec, block.First), it_ = std::ranges::upper_bound(charVec, block.Last); it != it_; ++it) {
-				xivres::util::unicode::represent_codepoint(containingChars, *it);
-				if (containingChars.size() >= 8192)
-					break;
-			}
+			pFaceData->Codepoints.ForEach(block.First, block.Last, [&containingChars](char32_t c) {
+				xivres::util::unicode::represent_codepoint(containingChars, c);
+				return containingChars.size() < 8192;
+			});
 
 			if (containingChars.size() >= 8192)
 				break;
@@ -552,10 +535,10 @@ INT_PTR App::FaceElementEditorDialog::UnicodeBlockSearchResultList_OnCommand(uin
 
 INT_PTR App::FaceElementEditorDialog::UnicodeBlockSearchAddAll_OnCommand(uint16_t notiCode) {
 	auto changed = false;
-	std::vector<char32_t> charVec(m_element.GetBaseFont()->all_codepoints().begin(), m_element.GetBaseFont()->all_codepoints().end());
+	const auto pFaceData = m_element.GetSharedFaceData();
 	for (int i = 0, i_ = ListBox_GetCount(m_controls->UnicodeBlockSearchResultList); i < i_; i++) {
 		const auto& block = *reinterpret_cast<const xivres::util::unicode::blocks::block_definition*>(ListBox_GetItemData(m_controls->UnicodeBlockSearchResultList, i));
-		changed |= AddNewCodepointRange(block.First, block.Last, charVec);
+		changed |= AddNewCodepointRange(block.First, block.Last, pFaceData->Codepoints);
 	}
 
 	if (changed)
@@ -572,10 +555,10 @@ INT_PTR App::FaceElementEditorDialog::UnicodeBlockSearchAdd_OnCommand(uint16_t n
 	ListBox_GetSelItems(m_controls->UnicodeBlockSearchResultList, static_cast<int>(selItems.size()), selItems.data());
 
 	auto changed = false;
-	std::vector<char32_t> charVec(m_element.GetBaseFont()->all_codepoints().begin(), m_element.GetBaseFont()->all_codepoints().end());
+	const auto pFaceData = m_element.GetSharedFaceData();
 	for (const auto itemIndex : selItems) {
 		const auto& block = *reinterpret_cast<const xivres::util::unicode::blocks::block_definition*>(ListBox_GetItemData(m_controls->UnicodeBlockSearchResultList, itemIndex));
-		changed |= AddNewCodepointRange(block.First, block.Last, charVec);
+		changed |= AddNewCodepointRange(block.First, block.Last, pFaceData->Codepoints);
 	}
 
 	if (changed)
@@ -661,9 +644,9 @@ INT_PTR App::FaceElementEditorDialog::Dialog_OnInitDialog() {
 	SetWindowNumber(m_controls->AdjustmentHorizontalOffsetEdit, m_element.WrapModifiers.HorizontalOffset);
 	SetWindowNumber(m_controls->AdjustmentGammaEdit, m_element.Gamma);
 
-	std::vector<char32_t> charVec(m_element.GetBaseFont()->all_codepoints().begin(), m_element.GetBaseFont()->all_codepoints().end());
+	const auto pFaceData = m_element.GetSharedFaceData();
 	for (int i = 0, i_ = static_cast<int>(m_element.WrapModifiers.Codepoints.size()); i < i_; i++)
-		AddCodepointRangeToListBox(i, m_element.WrapModifiers.Codepoints[i].first, m_element.WrapModifiers.Codepoints[i].second, charVec);
+		AddCodepointRangeToListBox(i, m_element.WrapModifiers.Codepoints[i].first, m_element.WrapModifiers.Codepoints[i].second, pFaceData->Codepoints);
 
 	SetComboboxContent<xivres::fontgen::codepoint_merge_mode>(
 		m_controls->CodepointsMergeModeCombo,
@@ -867,7 +850,7 @@ std::vector<std::pair<char32_t, char32_t>> App::FaceElementEditorDialog::ParseCu
 	return ranges;
 }
 
-bool App::FaceElementEditorDialog::AddNewCodepointRange(char32_t c1, char32_t c2, const std::vector<char32_t>& charVec) {
+bool App::FaceElementEditorDialog::AddNewCodepointRange(char32_t c1, char32_t c2, const CodepointSet& codepoints) {
 	const auto newItem = std::make_pair(c1, c2);
 	const auto it = std::ranges::lower_bound(m_element.WrapModifiers.Codepoints, newItem);
 	if (it != m_element.WrapModifiers.Codepoints.end() && *it == newItem)
@@ -875,14 +858,12 @@ bool App::FaceElementEditorDialog::AddNewCodepointRange(char32_t c1, char32_t c2
 
 	const auto newIndex = static_cast<int>(it - m_element.WrapModifiers.Codepoints.begin());
 	m_element.WrapModifiers.Codepoints.insert(it, newItem);
-	AddCodepointRangeToListBox(newIndex, c1, c2, charVec);
+	AddCodepointRangeToListBox(newIndex, c1, c2, codepoints);
 	return true;
 }
 
-void App::FaceElementEditorDialog::AddCodepointRangeToListBox(int index, char32_t c1, char32_t c2, const std::vector<char32_t>& charVec) {
-	const auto left = std::ranges::lower_bound(charVec, c1);
-	const auto right = std::ranges::upper_bound(charVec, c2);
-	const auto count = right - left;
+void App::FaceElementEditorDialog::AddCodepointRangeToListBox(int index, char32_t c1, char32_t c2, const CodepointSet& codepoints) {
+	const auto count = codepoints.Count(c1, c2);
 
 	const auto block = std::lower_bound(xivres::util::unicode::blocks::all_blocks().begin(), xivres::util::unicode::blocks::all_blocks().end(), c1, [](const auto& l, const auto& r) { return l.First < r; });
 	if (block != xivres::util::unicode::blocks::all_blocks().end() && block->First == c1 && block->Last == c2) {
@@ -929,7 +910,7 @@ void App::FaceElementEditorDialog::RefreshUnicodeBlockSearchResults() {
 
 	const auto searchByChar = Button_GetCheck(m_controls->UnicodeBlockSearchShowBlocksWithAnyOfCharactersInput);
 
-	std::vector<char32_t> charVec(m_element.GetBaseFont()->all_codepoints().begin(), m_element.GetBaseFont()->all_codepoints().end());
+	const auto pFaceData = m_element.GetSharedFaceData();
 	for (const auto& block : xivres::util::unicode::blocks::all_blocks()) {
 		const auto nameView = std::string_view(block.Name);
 		const auto it = std::search(nameView.begin(), nameView.end(), input.begin(), input.end(), [](char ch1, char ch2) {
@@ -950,9 +931,8 @@ void App::FaceElementEditorDialog::RefreshUnicodeBlockSearchResults() {
 				continue;
 		}
 
-		const auto left = std::ranges::lower_bound(charVec, block.First);
-		const auto right = std::ranges::upper_bound(charVec, block.Last);
-		if (left == right)
+		const auto count = pFaceData->Codepoints.Count(block.First, block.Last);
+		if (!count)
 			continue;
 
 		ListBox_AddString(m_controls->UnicodeBlockSearchResultList, std::format(
@@ -960,7 +940,7 @@ void App::FaceElementEditorDialog::RefreshUnicodeBlockSearchResults() {
 			static_cast<uint32_t>(block.First),
 			static_cast<uint32_t>(block.Last),
 			xivres::util::unicode::convert<std::wstring>(nameView),
-			right - left,
+			count,
 			xivres::util::unicode::represent_codepoint<std::wstring>(block.First),
 			xivres::util::unicode::represent_codepoint<std::wstring>(block.Last)
 		).c_str());
@@ -1163,71 +1143,22 @@ void App::FaceElementEditorDialog::RepopulateFontCombobox() {
 
 		case Structs::RendererEnum::DirectWrite:
 		case Structs::RendererEnum::FreeType: {
-			IDWriteFactory3Ptr factory;
-			SuccessOrThrow(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory3), reinterpret_cast<IUnknown**>(&factory)));
-
-			IDWriteFontCollectionPtr coll;
-			SuccessOrThrow(factory->GetSystemFontCollection(&coll));
-
-			m_fontFamilies.clear();
-			std::vector<std::wstring> names;
-			auto curNameLower = xivres::util::unicode::convert<std::wstring>(m_element.Lookup.Name);
-			CharLowerBuffW(curNameLower.data(), static_cast<DWORD>(curNameLower.size()));
-			for (uint32_t i = 0, i_ = coll->GetFontFamilyCount(); i < i_; i++) {
-				IDWriteFontFamilyPtr family;
-				IDWriteLocalizedStringsPtr strings;
-
-				if (FAILED(coll->GetFontFamily(i, &family)))
-					continue;
-
-				if (FAILED(family->GetFamilyNames(&strings)))
-					continue;
+			m_fontCatalogue = FontFamilyCatalogue::Get();
+			const auto& families = m_fontCatalogue->GetFamilies();
 
-				uint32_t indexEng;
-				if (BOOL exists; FAILED(strings->FindLocaleName(L"en-us", &indexEng, &exists)) || !exists) {
-					if (FAILED(strings->FindLocaleName(L"en", &indexEng, &exists)) || !exists)
-						indexEng = 0;
-				}
-
-				uint32_t index;
-				if (BOOL exists; FAILED(strings->FindLocaleName(g_localeName.c_str(), &index, &exists)) || !exists)
-					index = indexEng;
-
-				uint32_t length;
-				if (FAILED(strings->GetStringLength(index, &length)))
-					continue;
-
-				std::wstring res(length + 1, L'\0');
-				if (FAILED(strings->GetString(index, res.data(), length + 1)))
-					continue;
-				res.resize(length);
-
-				std::wstring resLower = res;
-				CharLowerBuffW(resLower.data(), static_cast<DWORD>(resLower.size()));
-
-				const auto insertAt = std::ranges::lower_bound(names, resLower) - names.begin();
+			size_t totalLength = 0;
+			for (const auto& family : families)
+				totalLength += family.Name.size() + 1;
 
-				ComboBox_InsertString(m_controls->FontCombo, insertAt, res.c_str());
-				m_fontFamilies.insert(m_fontFamilies.begin() + insertAt, std::move(family));
+			SetWindowRedraw(m_controls->FontCombo, FALSE);
+			SendMessageW(m_controls->FontCombo, CB_INITSTORAGE, families.size(), totalLength * sizeof(wchar_t));
+			for (const auto& family : families)
+				ComboBox_AddString(m_controls->FontCombo, family.Name.c_str());
+			SetWindowRedraw(m_controls->FontCombo, TRUE);
+			InvalidateRect(m_controls->FontCombo, nullptr, FALSE);
 
-				if (curNameLower == resLower) {
-					ComboBox_SetCurSel(m_controls->FontCombo, insertAt);
-				} else if (indexEng != index) {
-					if (FAILED(strings->GetStringLength(indexEng, &length)))
-						continue;
-
-					std::wstring res(length + 1, L'\0');
-					if (FAILED(strings->GetString(indexEng, res.data(), length + 1)))
-						continue;
-					res.resize(length);
-
-					CharLowerBuffW(res.data(), static_cast<DWORD>(res.size()));
-					if (curNameLower == res)
-						ComboBox_SetCurSel(m_controls->FontCombo, insertAt);
-				}
-
-				names.insert(names.begin() + insertAt, std::move(resLower));
-			}
+			if (const auto index = m_fontCatalogue->Find(xivres::util::unicode::convert<std::wstring>(m_element.Lookup.Name)))
+				ComboBox_SetCurSel(m_controls->FontCombo, static_cast<int>(*index));
 
 			break;
 		}
@@ -1274,17 +1205,15 @@ void App::FaceElementEditorDialog::RepopulateFontSubComboBox() {
 
 		case Structs::RendererEnum::DirectWrite:
 		case Structs::RendererEnum::FreeType: {
-			IDWriteFactory3Ptr factory;
-			SuccessOrThrow(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory3), reinterpret_cast<IUnknown**>(&factory)));
-
 			IDWriteTextAnalyzerPtr analyzer;
-			SuccessOrThrow(factory->CreateTextAnalyzer(&analyzer));
+			SuccessOrThrow(FontFamilyCatalogue::GetFactory()->CreateTextAnalyzer(&analyzer));
 
 			IDWriteTextAnalyzer2Ptr analyzer2;
 			SuccessOrThrow(analyzer->QueryInterface(&analyzer2));
 			
-			const auto curSel = (std::max)(0, (std::min)(static_cast<int>(m_fontFamilies.size() - 1), ComboBox_GetCurSel(m_controls->FontCombo)));
-			const auto& family = m_fontFamilies[curSel];
+			const auto& families = m_fontCatalogue->GetFamilies();
+			const auto curSel = (std::max)(0, (std::min)(static_cast<int>(families.size() - 1), ComboBox_GetCurSel(m_controls->FontCombo)));
+			const auto& family = families[curSel].FontFamily;
 			std::set<DWRITE_FONT_WEIGHT> weights;
 			std::set<DWRITE_FONT_STYLE> styles;
 			std::set<DWRITE_FONT_STRETCH> stretches;
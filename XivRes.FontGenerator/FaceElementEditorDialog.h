@@ -1,5 +1,6 @@
 #pragma once
 
+#include "FontFamilyCatalogue.h"
 #include "Structs.h"
 
 namespace App {
@@ -14,7 +15,7 @@ namespace App {
 		bool m_bBaseFontChanged = false;
 		bool m_bWrappedFontChanged = false;
 
-		std::vector<IDWriteFontFamilyPtr> m_fontFamilies;
+		std::shared_ptr<const FontFamilyCatalogue> m_fontCatalogue;
 
 		ControlStruct* m_controls = nullptr;
 
@@ -113,8 +114,8 @@ namespace App {
 		INT_PTR Dialog_OnInitDialog();
 
 		std::vector<std::pair<char32_t, char32_t>> ParseCustomRangeString();
-		bool AddNewCodepointRange(char32_t c1, char32_t c2, const std::vector<char32_t>& charVec);
-		void AddCodepointRangeToListBox(int index, char32_t c1, char32_t c2, const std::vector<char32_t>& charVec);
+		bool AddNewCodepointRange(char32_t c1, char32_t c2, const CodepointSet& codepoints);
+		void AddCodepointRangeToListBox(int index, char32_t c1, char32_t c2, const CodepointSet& codepoints);
 		void RefreshUnicodeBlockSearchResults();
 
 		void SetControlsEnabledOrDisabled();
@@ -0,0 +1,552 @@
+#include "pch.h"
+#include "FontDataCache.h"
+#include "FontGeneratorConfig.h"
+#include "MappedFileStream.h"
+
+static constexpr uint32_t CacheFileMagic = 0x43465258; // "XRFC"
+static constexpr uint32_t CacheFileVersion = 2;
+
+// Texture pages are mostly empty, so even the fastest compression level shrinks them by a lot.
+static constexpr int PageCompressionLevel = Z_BEST_SPEED;
+
+// Number of codepoints drawn by one worker at a time when rasterizing glyphs to be cached.
+static constexpr size_t RasterizeBlockSize = 2048;
+
+// Side length of the pages glyphs to be cached are packed into.
+static constexpr int RasterizeSideLength = 4096;
+
+// Memory taken by one page of a block being rasterized, as 32bpp.
+static constexpr uint64_t RasterizePageMemory = static_cast<uint64_t>(RasterizeSideLength) * RasterizeSideLength * 4;
+
+// Temporary files older than this are left over from a process that stopped while storing, rather than being written right now.
+static constexpr auto StaleTemporaryFileAge = std::chrono::hours(1);
+
+static App::FontDataCache::FontDataSet PackFont(std::shared_ptr<xivres::fontgen::fixed_size_font> font) {
+	xivres::fontgen::fontdata_packer packer;
+	packer.set_side_length(RasterizeSideLength);
+	packer.add_font(std::move(font));
+	packer.compile();
+	while (!packer.wait(std::chrono::milliseconds(200))) {}
+	if (const auto err = packer.get_error_if_failed(); !err.empty())
+		throw std::runtime_error(err);
+
+	App::FontDataCache::FontDataSet res(packer.compiled_fontdatas(), packer.compiled_mipmap_streams());
+	if (res.first.size() != 1 || res.second.empty())
+		throw std::runtime_error("Unexpected packing result");
+	return res;
+}
+
+static std::vector<std::pair<char32_t, char32_t>> ToRanges(const std::vector<char32_t>& sortedCodepoints) {
+	std::vector<std::pair<char32_t, char32_t>> res;
+	for (const auto c : sortedCodepoints) {
+		if (!res.empty() && res.back().second + 1 == c)
+			res.back().second = c;
+		else
+			res.emplace_back(c, c);
+	}
+	return res;
+}
+
+App::FontDataCache::FontDataCache(std::filesystem::path dir)
+	: m_dir(std::move(dir)) {}
+
+std::shared_ptr<App::FontDataCache> App::FontDataCache::Open(const std::filesystem::path& dir) {
+	static std::mutex s_mtx;
+	static std::map<std::filesystem::path, std::shared_ptr<FontDataCache>> s_caches;
+
+	const auto lock = std::lock_guard(s_mtx);
+	auto& cache = s_caches[dir];
+	if (!cache)
+		cache = std::make_shared<FontDataCache>(dir);
+	return cache;
+}
+
+std::filesystem::path App::FontDataCache::GetDefaultDirectory() {
+	PWSTR pszPath = nullptr;
+	const auto freePath = xivres::util::on_dtor([&pszPath]() { CoTaskMemFree(pszPath); });
+	if (FAILED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &pszPath)))
+		return FontGeneratorConfig::GetConfigPath().parent_path() / "cache";
+
+	return std::filesystem::path(pszPath) / "XivRes.FontGenerator" / "cache";
+}
+
+uint64_t App::FontDataCache::Hash(std::span<const uint8_t> data, uint64_t hash) {
+	for (const auto b : data) {
+		hash ^= b;
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+uint64_t App::FontDataCache::Hash(std::string_view data, uint64_t hash) {
+	return Hash(std::span(reinterpret_cast<const uint8_t*>(data.data()), data.size()), hash);
+}
+
+uint64_t App::FontDataCache::Hash(const xivres::stream& stream, uint64_t hash) {
+	if (const auto pMapped = dynamic_cast<const MappedFileStream*>(&stream))
+		return Hash(pMapped->as_span(), hash);
+
+	std::vector<uint8_t> buf(1048576);
+	for (size_t read, pos = 0; (read = stream.read(pos, buf.data(), buf.size())); pos += read)
+		hash = Hash(std::span(buf).subspan(0, read), hash);
+	return hash;
+}
+
+std::optional<App::FontDataCache::FontDataSet> App::FontDataCache::Load(uint64_t key) const {
+	const auto path = GetPath(key);
+	std::vector<uint8_t> buf;
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			return std::nullopt;
+
+		in.seekg(0, std::ios::end);
+		buf.resize(static_cast<size_t>(in.tellg()));
+		in.seekg(0, std::ios::beg);
+		if (!in.read(reinterpret_cast<char*>(buf.data()), buf.size()))
+			return std::nullopt;
+	}
+
+	// Mark the file as recently used, so that Trim removes it last.
+	std::error_code ec;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+	std::span remaining(buf);
+	const auto readBytes = [&remaining](size_t size) -> std::span<const uint8_t> {
+		if (remaining.size() < size)
+			throw std::runtime_error("Truncated cache file");
+
+		const auto res = remaining.subspan(0, size);
+		remaining = remaining.subspan(size);
+		return res;
+	};
+	const auto readValue = [&readBytes]<typename T>(T&) -> T {
+		T v;
+		memcpy(&v, readBytes(sizeof v).data(), sizeof v);
+		return v;
+	};
+
+	try {
+		uint32_t u32{};
+		uint64_t u64{};
+		if (readValue(u32) != CacheFileMagic || readValue(u32) != CacheFileVersion)
+			return std::nullopt;
+
+		FontDataSet res;
+		res.first.resize(readValue(u32));
+		for (auto& fdt : res.first) {
+			const auto data = readBytes(static_cast<size_t>(readValue(u64)));
+			fdt = std::make_shared<xivres::fontdata::stream>(xivres::memory_stream(std::vector<uint8_t>(data.begin(), data.end())));
+		}
+
+		res.second.resize(readValue(u32));
+		for (auto& mip : res.second) {
+			const auto type = static_cast<xivres::texture::formats>(readValue(u32));
+			const auto width = readValue(u32);
+			const auto height = readValue(u32);
+			const auto size = readValue(u64);
+			const auto data = readBytes(static_cast<size_t>(readValue(u64)));
+
+			mip = std::make_shared<xivres::texture::memory_mipmap_stream>(width, height, 1, type);
+			const auto target = mip->as_span<uint8_t>();
+			auto targetSize = static_cast<uLongf>(target.size());
+			if (target.size() != size
+				|| Z_OK != uncompress(target.data(), &targetSize, data.data(), static_cast<uLong>(data.size()))
+				|| targetSize != target.size())
+				return std::nullopt;
+		}
+
+		if (!remaining.empty())
+			return std::nullopt;
+
+		return res;
+	} catch (const std::exception&) {
+		return std::nullopt;
+	}
+}
+
+void App::FontDataCache::Store(uint64_t key, const FontDataSet& data, xivres::util::thread_pool::pool& pool) const {
+	const auto path = GetPath(key);
+	auto tmpPath = path;
+	tmpPath += std::format(L".{}.tmp", GetCurrentThreadId());
+	const auto removeTmpPath = xivres::util::on_dtor([&tmpPath]() {
+		std::error_code ec;
+		std::filesystem::remove(tmpPath, ec);
+	});
+
+	std::vector<std::vector<uint8_t>> compressedPages(data.second.size());
+	auto bFailed = false;
+	{
+		xivres::util::thread_pool::task_waiter<bool> waiter(pool);
+		for (size_t i = 0; i < data.second.size(); i++) {
+			waiter.submit([&source = *data.second[i], &target = compressedPages[i]](auto&) -> bool {
+				// Compress into a scratch buffer first, so that only the compressed size stays allocated until written.
+				const auto bytes = source.as_span<uint8_t>();
+				std::vector<uint8_t> buf(compressBound(static_cast<uLong>(bytes.size())));
+				auto size = static_cast<uLongf>(buf.size());
+				if (Z_OK != compress2(buf.data(), &size, bytes.data(), static_cast<uLong>(bytes.size()), PageCompressionLevel))
+					return false;
+				target.assign(buf.begin(), buf.begin() + size);
+				return true;
+			});
+		}
+
+		for (std::optional<bool> res; (res = waiter.get());)
+			bFailed |= !*res;
+	}
+	if (bFailed)
+		throw std::runtime_error("Failed to compress cache data");
+
+	create_directories(m_dir);
+	{
+		std::ofstream out(tmpPath, std::ios::binary);
+		if (!out)
+			throw std::runtime_error("Failed to create cache file");
+
+		const auto writeValue = [&out]<typename T>(const T& v) {
+			out.write(reinterpret_cast<const char*>(&v), sizeof v);
+		};
+
+		std::vector<char> buf(1048576);
+		const auto writeStream = [&out, &buf, &writeValue](const xivres::stream& stream, uint64_t size) {
+			writeValue(size);
+			for (size_t read, pos = 0; (read = stream.read(pos, buf.data(), buf.size())); pos += read)
+				out.write(buf.data(), read);
+		};
+
+		writeValue(CacheFileMagic);
+		writeValue(CacheFileVersion);
+
+		writeValue(static_cast<uint32_t>(data.first.size()));
+		for (const auto& fdt : data.first) {
+			uint64_t size = 0;
+			for (size_t read, pos = 0; (read = fdt->read(pos, buf.data(), buf.size())); pos += read)
+				size += read;
+			writeStream(*fdt, size);
+		}
+
+		writeValue(static_cast<uint32_t>(data.second.size()));
+		for (size_t i = 0; i < data.second.size(); i++) {
+			const auto& mip = *data.second[i];
+			writeValue(static_cast<uint32_t>(mip.Type));
+			writeValue(static_cast<uint32_t>(mip.Width));
+			writeValue(static_cast<uint32_t>(mip.Height));
+			writeValue(static_cast<uint64_t>(mip.as_span<uint8_t>().size()));
+			writeValue(static_cast<uint64_t>(compressedPages[i].size()));
+			out.write(reinterpret_cast<const char*>(compressedPages[i].data()), compressedPages[i].size());
+		}
+
+		if (!out)
+			throw std::runtime_error("Failed to write cache file");
+	}
+
+	std::filesystem::rename(tmpPath, path);
+	Trim();
+}
+
+std::optional<uint64_t> App::FontDataCache::GetGlyphsKey(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints) {
+	switch (element.Renderer) {
+		case Structs::RendererEnum::DirectWrite:
+		case Structs::RendererEnum::FreeType:
+			break;
+
+		default:
+			return std::nullopt;
+	}
+
+	const auto sourceHash = GetSourceHash(element);
+	if (!sourceHash)
+		return std::nullopt;
+
+	auto key = Hash(std::format("{:016x}:{}", GetProgramHash(), element.GetBaseFontKey()), *sourceHash);
+	return Hash(std::span(reinterpret_cast<const uint8_t*>(codepoints.data()), codepoints.size() * sizeof codepoints[0]), key);
+}
+
+std::shared_ptr<xivres::fontgen::fixed_size_font> App::FontDataCache::LoadBaseFont(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints) {
+	const auto key = GetGlyphsKey(element, codepoints);
+	if (!key)
+		return element.GetBaseFont();
+
+	{
+		const auto lock = std::lock_guard(m_loadedFontsMtx);
+		if (auto pFont = m_loadedFonts[*key].lock())
+			return pFont;
+	}
+
+	const auto data = Load(*key);
+	if (!data)
+		return nullptr;
+
+	std::shared_ptr<xivres::fontgen::fixed_size_font> pFont = std::make_shared<xivres::fontgen::fontdata_fixed_size_font>(data->first[0], data->second, element.Lookup.Name, "");
+
+	const auto lock = std::lock_guard(m_loadedFontsMtx);
+	m_loadedFonts[*key] = pFont;
+	return pFont;
+}
+
+std::shared_ptr<xivres::fontgen::fixed_size_font> App::FontDataCache::RasterizeBaseFont(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints, xivres::util::thread_pool::pool& pool) {
+	const auto key = GetGlyphsKey(element, codepoints);
+	if (!key)
+		return element.GetBaseFont();
+
+	FontDataSet data;
+	try {
+		data = Rasterize(element, codepoints, pool);
+	} catch (const std::exception&) {
+		return element.GetBaseFont();
+	}
+
+	try {
+		Store(*key, data, pool);
+	} catch (const std::exception&) {
+		// Failing to write the cache is fine; glyphs will be rendered again next time.
+	}
+
+	std::shared_ptr<xivres::fontgen::fixed_size_font> pFont = std::make_shared<xivres::fontgen::fontdata_fixed_size_font>(data.first[0], data.second, element.Lookup.Name, "");
+
+	const auto lock = std::lock_guard(m_loadedFontsMtx);
+	m_loadedFonts[*key] = pFont;
+	return pFont;
+}
+
+App::FontDataCache::FontDataSet App::FontDataCache::Rasterize(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints, xivres::util::thread_pool::pool& pool) {
+	const auto& pBaseFont = element.GetBaseFont();
+	const auto wrap = [&pBaseFont](std::vector<std::pair<char32_t, char32_t>> ranges) {
+		xivres::fontgen::wrap_modifiers wrapModifiers;
+		wrapModifiers.Codepoints = std::move(ranges);
+		return std::make_shared<xivres::fontgen::wrapping_fixed_size_font>(pBaseFont, wrapModifiers);
+	};
+
+	// Ranges are sorted and merged by the caller.
+	std::vector<char32_t> available;
+	for (const auto c : pBaseFont->all_codepoints()) {
+		const auto it = std::ranges::upper_bound(codepoints, c, {}, [](const auto& range) { return range.first; });
+		if (it != codepoints.begin() && c <= std::prev(it)->second)
+			available.emplace_back(c);
+	}
+	if (available.size() <= RasterizeBlockSize)
+		return PackFont(wrap(codepoints));
+
+	// Kerning only applies between glyphs from the same font, so codepoints connected by kerning pairs must stay in one block.
+	// Group them into components, and fill blocks with whole components in the order of their first codepoints.
+	// A component larger than a block, such as one connecting most of the letters of a script, makes a block of its own.
+	std::map<char32_t, char32_t> parents;
+	const auto find = [&parents](char32_t c) {
+		while (parents.at(c) != c)
+			c = parents.at(c) = parents.at(parents.at(c));
+		return c;
+	};
+	for (const auto c : available)
+		parents.emplace(c, c);
+	for (const auto& [left, right] : pBaseFont->all_kerning_pairs() | std::views::keys) {
+		if (!parents.contains(left) || !parents.contains(right))
+			continue;
+		const auto root1 = find(left);
+		const auto root2 = find(right);
+		parents.at((std::max)(root1, root2)) = (std::min)(root1, root2);
+	}
+
+	// Roots are the smallest codepoints of their components, so components come out ordered by them.
+	std::map<char32_t, std::vector<char32_t>> components;
+	for (const auto c : available)
+		components[find(c)].emplace_back(c);
+
+	std::vector<std::vector<char32_t>> blocks(1);
+	for (auto& component : components | std::views::values) {
+		if (!blocks.back().empty() && blocks.back().size() + component.size() > RasterizeBlockSize)
+			blocks.emplace_back();
+		blocks.back().insert(blocks.back().end(), component.begin(), component.end());
+	}
+	for (auto& block : blocks)
+		std::ranges::sort(block);
+
+	// Every block being packed takes a page, and keeps its pages until all blocks are merged; submit only as many as fit in the budget.
+	const auto memoryBudget = g_config.GetExportMemoryBudget();
+	std::vector<std::optional<FontDataSet>> results(blocks.size());
+	uint64_t memoryHeld = 0;
+	size_t nInFlight = 0;
+	xivres::util::thread_pool::task_waiter<size_t> waiter(pool);
+	const auto collect = [&]() {
+		const auto i = *waiter.get();
+		nInFlight--;
+		if (results[i]) {
+			for (const auto& mip : results[i]->second)
+				memoryHeld += mip->as_span<uint8_t>().size();
+		}
+	};
+	for (size_t i = 0; i < blocks.size(); i++) {
+		while (nInFlight && memoryHeld + (nInFlight + 1) * RasterizePageMemory > memoryBudget)
+			collect();
+
+		nInFlight++;
+		waiter.submit([&wrap, &blocks, &results, i](auto&) -> size_t {
+			try {
+				results[i] = PackFont(wrap(ToRanges(blocks[i])));
+			} catch (const std::exception&) {
+				// Reported below.
+			}
+			return i;
+		});
+	}
+	while (nInFlight)
+		collect();
+
+	// Put the blocks back together into one font; drawing from already rasterized glyphs is cheap.
+	std::vector<std::pair<std::shared_ptr<xivres::fontgen::fixed_size_font>, xivres::fontgen::codepoint_merge_mode>> parts;
+	for (const auto& result : results) {
+		if (!result)
+			throw std::runtime_error("Failed to rasterize glyphs");
+		parts.emplace_back(std::make_shared<xivres::fontgen::fontdata_fixed_size_font>(result->first[0], result->second, element.Lookup.Name, ""), xivres::fontgen::codepoint_merge_mode::AddNew);
+	}
+	return PackFont(std::make_shared<xivres::fontgen::merged_fixed_size_font>(std::move(parts)));
+}
+
+std::optional<uint64_t> App::FontDataCache::GetFontSetKey(const Structs::FontSet& fontSet) {
+	nlohmann::json json = fontSet;
+	json.erase("expectedTexCount");
+	for (auto& face : json.at("faces"))
+		face.erase("previewText");
+
+	auto hash = Hash(std::format("fontset:{}:{:016x}:", CacheFileVersion, GetProgramHash()));
+	hash = Hash(json.dump(), hash);
+
+	auto bGameFontUsed = false;
+	for (const auto& pFace : fontSet.Faces) {
+		for (const auto& pElem : pFace->Elements) {
+			switch (pElem->Renderer) {
+				case Structs::RendererEnum::PrerenderedGameInstallation:
+					bGameFontUsed = true;
+					break;
+
+				case Structs::RendererEnum::DirectWrite:
+				case Structs::RendererEnum::FreeType: {
+					const auto sourceHash = GetSourceHash(*pElem);
+					if (!sourceHash)
+						return std::nullopt;
+					hash = Hash(std::span(reinterpret_cast<const uint8_t*>(&*sourceHash), sizeof *sourceHash), hash);
+					break;
+				}
+			}
+		}
+	}
+
+	if (bGameFontUsed) {
+		const auto gameHash = GetGameInstallationsHash();
+		hash = Hash(std::span(reinterpret_cast<const uint8_t*>(&gameHash), sizeof gameHash), hash);
+	}
+
+	return hash;
+}
+
+std::optional<uint64_t> App::FontDataCache::GetSourceHash(const Structs::FaceElement& element) {
+	const auto bFreeType = element.Renderer == Structs::RendererEnum::FreeType;
+
+	try {
+		const auto [path, index] = element.Lookup.ResolveFilePath(bFreeType);
+
+		// Fonts not coming from a file can only be told apart by their content.
+		if (path.empty()) {
+			const auto [pStream, streamIndex] = bFreeType ? element.Lookup.ResolveFreeTypeStream() : element.Lookup.ResolveStream();
+			return Hash(std::format("{}:{}", CacheFileVersion, streamIndex), Hash(*pStream));
+		}
+
+		// A font file replaced while the program is running will have a different size or modification time, and gets hashed again.
+		const auto fileKey = std::format("{}:{}:{}:{}",
+			xivres::util::unicode::convert<std::string>(path.wstring()),
+			index,
+			std::filesystem::file_size(path),
+			std::filesystem::last_write_time(path).time_since_epoch().count());
+		{
+			const auto lock = std::lock_guard(m_sourceHashesMtx);
+			if (const auto it = m_sourceHashes.find(fileKey); it != m_sourceHashes.end())
+				return it->second;
+		}
+
+		const auto hash = Hash(std::format("{}:{}", CacheFileVersion, index), Hash(*MappedFileStream::Open(path)));
+
+		const auto lock = std::lock_guard(m_sourceHashesMtx);
+		m_sourceHashes.emplace(fileKey, hash);
+		return hash;
+	} catch (const std::exception&) {
+		return std::nullopt;
+	}
+}
+
+uint64_t App::FontDataCache::GetProgramHash() {
+	// xivres is linked into the program file, so the same file draws and packs glyphs the same way.
+	static const auto s_hash = []() {
+		std::wstring path(PATHCCH_MAX_CCH + 1, L'\0');
+		path.resize(GetModuleFileNameW(GetModuleHandle(nullptr), path.data(), static_cast<DWORD>(path.size())));
+		try {
+			return Hash(MappedFileStream(path));
+		} catch (const std::exception&) {
+			// Caches of every build will be mixed up, but CacheFileVersion still tells incompatible formats apart.
+			return HashSeed;
+		}
+	}();
+	return s_hash;
+}
+
+uint64_t App::FontDataCache::GetGameInstallationsHash() {
+	// Game font data only changes with game updates, so use the version files instead of reading through the game data.
+	auto hash = HashSeed;
+	for (const auto& pathList : {g_config.Global, g_config.China, g_config.Korea, g_config.TraditionalChinese}) {
+		for (const auto& path : pathList) {
+			hash = Hash(xivres::util::unicode::convert<std::string>(path.wstring()), hash);
+			if (std::ifstream in(path / "ffxivgame.ver"); in) {
+				std::string version;
+				std::getline(in, version);
+				hash = Hash(version, hash);
+			}
+		}
+	}
+	return hash;
+}
+
+std::filesystem::path App::FontDataCache::GetPath(uint64_t key) const {
+	return m_dir / std::format("{:016x}.bin", key);
+}
+
+void App::FontDataCache::Trim() const {
+	const auto limit = static_cast<uint64_t>(g_config.CacheSizeLimitMB) * 1024 * 1024;
+	const auto staleBefore = std::filesystem::file_time_type::clock::now() - StaleTemporaryFileAge;
+
+	const auto lock = std::lock_guard(m_trimMtx);
+
+	uint64_t totalSize = 0;
+	std::vector<std::tuple<std::filesystem::file_time_type, uint64_t, std::filesystem::path>> files;
+	std::error_code ec;
+	for (auto it = std::filesystem::directory_iterator(m_dir, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+		const auto extension = it->path().extension();
+		if ((extension != L".bin" && extension != L".tmp") || !it->is_regular_file(ec))
+			continue;
+
+		const auto size = it->file_size(ec);
+		const auto lastWriteTime = it->last_write_time(ec);
+		if (ec) {
+			ec.clear();
+			continue;
+		}
+
+		if (extension == L".tmp") {
+			if (lastWriteTime < staleBefore)
+				std::filesystem::remove(it->path(), ec);
+			ec.clear();
+			continue;
+		}
+
+		files.emplace_back(lastWriteTime, size, it->path());
+		totalSize += size;
+	}
+
+	if (!limit)
+		return;
+
+	std::ranges::sort(files);
+	for (const auto& [lastWriteTime, size, path] : files) {
+		if (totalSize <= limit)
+			break;
+		if (std::filesystem::remove(path, ec))
+			totalSize -= size;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Structs.h"
+
+namespace App {
+	class FontDataCache {
+	public:
+		using FontDataSet = std::pair<std::vector<std::shared_ptr<xivres::fontdata::stream>>, std::vector<std::shared_ptr<xivres::texture::memory_mipmap_stream>>>;
+
+		// FNV-1a 64-bit offset basis.
+		static constexpr uint64_t HashSeed = 0xCBF29CE484222325ULL;
+
+	private:
+		const std::filesystem::path m_dir;
+
+		// Hashes of font files, keyed by their paths, face indices, sizes and modification times.
+		std::mutex m_sourceHashesMtx;
+		std::map<std::string, uint64_t> m_sourceHashes;
+
+		mutable std::mutex m_trimMtx;
+
+		std::mutex m_loadedFontsMtx;
+		std::map<uint64_t, std::weak_ptr<xivres::fontgen::fixed_size_font>> m_loadedFonts;
+
+	public:
+		FontDataCache(std::filesystem::path dir);
+
+		// Get the cache for the directory shared within the process, so that fonts loaded from it can be reused across exports.
+		static std::shared_ptr<FontDataCache> Open(const std::filesystem::path& dir);
+
+		// Get the directory under %LOCALAPPDATA% to keep the cache in.
+		static std::filesystem::path GetDefaultDirectory();
+
+		static uint64_t Hash(std::span<const uint8_t> data, uint64_t hash = HashSeed);
+		static uint64_t Hash(std::string_view data, uint64_t hash = HashSeed);
+		static uint64_t Hash(const xivres::stream& stream, uint64_t hash = HashSeed);
+
+		std::optional<FontDataSet> Load(uint64_t key) const;
+
+		// Compress the pages on the workers of the pool, and write the file from the calling thread.
+		void Store(uint64_t key, const FontDataSet& data, xivres::util::thread_pool::pool& pool) const;
+
+		// Get a font that draws the same as the base font of the element in given codepoint ranges, from glyphs rasterized earlier.
+		// Returns the base font itself if the renderer does not benefit from caching, or null if the glyphs are not in the cache yet.
+		std::shared_ptr<xivres::fontgen::fixed_size_font> LoadBaseFont(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints);
+
+		// Rasterize the glyphs that LoadBaseFont did not find, store them, and get a font drawing from the rasterized data,
+		// so that a miss gives the same output as a hit. Blocks of glyphs are drawn on the workers of the pool; do not call from one.
+		// Returns the base font itself if the renderer does not benefit from caching, or if rasterizing failed.
+		std::shared_ptr<xivres::fontgen::fixed_size_font> RasterizeBaseFont(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints, xivres::util::thread_pool::pool& pool);
+
+		// Get the key of the compilation result of the FontSet, from its definition and the fonts it uses.
+		// Values that do not affect the result, such as ExpectedTexCount and preview texts, are not part of the key.
+		// Returns nothing if any of the fonts could not be resolved.
+		std::optional<uint64_t> GetFontSetKey(const Structs::FontSet& fontSet);
+
+		std::optional<uint64_t> GetSourceHash(const Structs::FaceElement& element);
+
+	private:
+		static uint64_t GetGameInstallationsHash();
+
+		// Get the hash of the program file, so that results made by another build are never used.
+		static uint64_t GetProgramHash();
+
+		// Get the key of the glyphs of the base font of the element in given codepoint ranges, if the renderer benefits from caching.
+		std::optional<uint64_t> GetGlyphsKey(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints);
+
+		// Draw the glyphs of the base font of the element in given codepoint ranges into a font data set.
+		// Large sets are drawn in blocks on the workers of the pool, as many at once as FontGeneratorConfig::GetExportMemoryBudget allows.
+		// Blocks are made from the codepoints and kerning pairs alone, so the result does not depend on the number of threads.
+		static FontDataSet Rasterize(const Structs::FaceElement& element, const std::vector<std::pair<char32_t, char32_t>>& codepoints, xivres::util::thread_pool::pool& pool);
+
+		std::filesystem::path GetPath(uint64_t key) const;
+
+		// Remove the least recently used files until the cache fits in FontGeneratorConfig::CacheSizeLimitMB,
+		// and temporary files left behind by exports that were killed while storing.
+		void Trim() const;
+	};
+}
@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "FontFamilyCatalogue.h"
+
+static std::mutex s_catalogueMtx;
+static std::shared_future<std::shared_ptr<const App::FontFamilyCatalogue>> s_catalogue;
+
+static std::wstring GetLocalizedString(IDWriteLocalizedStrings* strings, uint32_t index) {
+	uint32_t length;
+	if (FAILED(strings->GetStringLength(index, &length)))
+		return {};
+
+	std::wstring res(length + 1, L'\0');
+	if (FAILED(strings->GetString(index, res.data(), length + 1)))
+		return {};
+	res.resize(length);
+	return res;
+}
+
+App::FontFamilyCatalogue::FontFamilyCatalogue(const std::wstring& localeName) {
+	const auto& coll = GetSystemFontCollection();
+
+	m_families.reserve(coll->GetFontFamilyCount());
+	for (uint32_t i = 0, i_ = coll->GetFontFamilyCount(); i < i_; i++) {
+		IDWriteFontFamilyPtr family;
+		IDWriteLocalizedStringsPtr strings;
+
+		if (FAILED(coll->GetFontFamily(i, &family)))
+			continue;
+
+		if (FAILED(family->GetFamilyNames(&strings)))
+			continue;
+
+		uint32_t indexEng;
+		if (BOOL exists; FAILED(strings->FindLocaleName(L"en-us", &indexEng, &exists)) || !exists) {
+			if (FAILED(strings->FindLocaleName(L"en", &indexEng, &exists)) || !exists)
+				indexEng = 0;
+		}
+
+		uint32_t index;
+		if (BOOL exists; FAILED(strings->FindLocaleName(localeName.c_str(), &index, &exists)) || !exists)
+			index = indexEng;
+
+		auto name = GetLocalizedString(strings, index);
+		if (name.empty())
+			continue;
+
+		auto englishName = index == indexEng ? name : GetLocalizedString(strings, indexEng);
+		if (englishName.empty())
+			englishName = name;
+
+		m_families.emplace_back(Family{
+			.Name = std::move(name),
+			.EnglishName = std::move(englishName),
+			.FontFamily = std::move(family),
+		});
+	}
+
+	const auto toLower = [](std::wstring s) {
+		CharLowerBuffW(s.data(), static_cast<DWORD>(s.size()));
+		return s;
+	};
+
+	std::vector<std::pair<std::wstring, size_t>> order;
+	order.reserve(m_families.size());
+	for (size_t i = 0; i < m_families.size(); i++)
+		order.emplace_back(toLower(m_families[i].Name), i);
+	std::ranges::stable_sort(order, {}, &std::pair<std::wstring, size_t>::first);
+
+	std::vector<Family> sorted;
+	sorted.reserve(m_families.size());
+	for (auto& [nameLower, i] : order) {
+		m_nameIndex.emplace_back(std::move(nameLower), sorted.size());
+		if (m_families[i].EnglishName != m_families[i].Name)
+			m_nameIndex.emplace_back(toLower(m_families[i].EnglishName), sorted.size());
+		sorted.emplace_back(std::move(m_families[i]));
+	}
+	m_families = std::move(sorted);
+	std::ranges::stable_sort(m_nameIndex, {}, &std::pair<std::wstring, size_t>::first);
+}
+
+const IDWriteFactory3Ptr& App::FontFamilyCatalogue::GetFactory() {
+	static const auto s_factory = []() {
+		IDWriteFactory3Ptr factory;
+		SuccessOrThrow(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory3), reinterpret_cast<IUnknown**>(&factory)));
+		return factory;
+	}();
+	return s_factory;
+}
+
+const IDWriteFontCollectionPtr& App::FontFamilyCatalogue::GetSystemFontCollection() {
+	static const auto s_collection = []() {
+		IDWriteFontCollectionPtr coll;
+		SuccessOrThrow(GetFactory()->GetSystemFontCollection(&coll));
+		return coll;
+	}();
+	return s_collection;
+}
+
+void App::FontFamilyCatalogue::BeginLoad() {
+	const auto lock = std::lock_guard(s_catalogueMtx);
+	if (s_catalogue.valid())
+		return;
+
+	s_catalogue = std::async(std::launch::async, [localeName = g_localeName]() {
+		return std::shared_ptr<const FontFamilyCatalogue>(new FontFamilyCatalogue(localeName));
+	}).share();
+}
+
+std::shared_ptr<const App::FontFamilyCatalogue> App::FontFamilyCatalogue::Get() {
+	BeginLoad();
+
+	std::shared_future<std::shared_ptr<const FontFamilyCatalogue>> catalogue;
+	{
+		const auto lock = std::lock_guard(s_catalogueMtx);
+		catalogue = s_catalogue;
+	}
+
+	try {
+		return catalogue.get();
+	} catch (...) {
+		// Try again next time.
+		const auto lock = std::lock_guard(s_catalogueMtx);
+		s_catalogue = {};
+		throw;
+	}
+}
+
+const std::vector<App::FontFamilyCatalogue::Family>& App::FontFamilyCatalogue::GetFamilies() const {
+	return m_families;
+}
+
+std::optional<size_t> App::FontFamilyCatalogue::Find(std::wstring name) const {
+	CharLowerBuffW(name.data(), static_cast<DWORD>(name.size()));
+	const auto it = std::ranges::lower_bound(m_nameIndex, name, {}, &std::pair<std::wstring, size_t>::first);
+	if (it == m_nameIndex.end() || it->first != name)
+		return std::nullopt;
+	return it->second;
+}
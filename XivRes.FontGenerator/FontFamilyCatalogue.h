@@ -0,0 +1,38 @@
+#pragma once
+
+namespace App {
+	// List of the font families installed to the system, sorted by their names in the user's language.
+	// Built once per process on a worker thread, and shared by every editor dialog.
+	class FontFamilyCatalogue {
+	public:
+		struct Family {
+			std::wstring Name;
+			std::wstring EnglishName;
+			IDWriteFontFamilyPtr FontFamily;
+		};
+
+	private:
+		std::vector<Family> m_families;
+
+		// Pairs of (lowercase localized or English name, index into m_families), sorted by name.
+		std::vector<std::pair<std::wstring, size_t>> m_nameIndex;
+
+		FontFamilyCatalogue(const std::wstring& localeName);
+
+	public:
+		static const IDWriteFactory3Ptr& GetFactory();
+
+		static const IDWriteFontCollectionPtr& GetSystemFontCollection();
+
+		// Start building the catalogue in background, if not started yet.
+		static void BeginLoad();
+
+		// Get the catalogue, waiting for it to be built if needed.
+		static std::shared_ptr<const FontFamilyCatalogue> Get();
+
+		[[nodiscard]] const std::vector<Family>& GetFamilies() const;
+
+		// Find a family by its localized or English name, ignoring case.
+		[[nodiscard]] std::optional<size_t> Find(std::wstring name) const;
+	};
+}
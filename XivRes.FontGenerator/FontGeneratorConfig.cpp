@@ -39,6 +39,18 @@ void from_json(const nlohmann::json& json, FontGeneratorConfig& value) {
 	}
 
 	value.Language = json.value("Language", "");
+	value.WorkerThreads = json.value<size_t>("workerThreads", 0);
+	value.ExportMemoryLimitMB = json.value<size_t>("exportMemoryLimitMB", 0);
+	value.UseGlyphCache = json.value<bool>("useGlyphCache", true);
+	value.UseCompiledFontSetCache = json.value<bool>("useCompiledFontSetCache", true);
+	value.GlyphCacheDirectory = xivres::util::unicode::convert<std::wstring>(json.value<std::string>("glyphCacheDirectory", ""));
+	value.CacheSizeLimitMB = json.value<size_t>("cacheSizeLimitMB", 2048);
+	value.ReproducibleExports = json.value<bool>("reproducibleExports", false);
+
+	if (auto it = json.find("fontDirectories"); it != json.end() && it->is_array()) {
+		for (const auto& [_, p] : it->items())
+			value.FontDirectories.emplace_back(xivres::util::unicode::convert<std::wstring>(p.get<std::string>()));
+	}
 }
 
 void to_json(nlohmann::json& json, const FontGeneratorConfig& value) {
@@ -65,6 +77,18 @@ void to_json(nlohmann::json& json, const FontGeneratorConfig& value) {
 	json.emplace("traditionalchinese", std::move(arr));
 
 	json.emplace("Language", value.Language);
+	json.emplace("workerThreads", value.WorkerThreads);
+	json.emplace("exportMemoryLimitMB", value.ExportMemoryLimitMB);
+	json.emplace("useGlyphCache", value.UseGlyphCache);
+	json.emplace("useCompiledFontSetCache", value.UseCompiledFontSetCache);
+	json.emplace("glyphCacheDirectory", xivres::util::unicode::convert<std::string>(value.GlyphCacheDirectory.wstring()));
+	json.emplace("cacheSizeLimitMB", value.CacheSizeLimitMB);
+	json.emplace("reproducibleExports", value.ReproducibleExports);
+
+	arr = {};
+	for (const auto& p : value.FontDirectories)
+		arr.emplace_back(xivres::util::unicode::convert<std::string>(p.wstring()));
+	json.emplace("fontDirectories", std::move(arr));
 }
 
 std::filesystem::path FontGeneratorConfig::GetConfigPath() {
@@ -78,6 +102,22 @@ std::filesystem::path FontGeneratorConfig::GetConfigPath() {
 	return std::filesystem::path(path).parent_path() / "config.json";
 }
 
+size_t FontGeneratorConfig::GetWorkerThreadCount() const {
+	if (WorkerThreads)
+		return WorkerThreads;
+	return (std::max)(1u, std::thread::hardware_concurrency());
+}
+
+uint64_t FontGeneratorConfig::GetExportMemoryBudget() const {
+	if (ExportMemoryLimitMB)
+		return static_cast<uint64_t>(ExportMemoryLimitMB) * 1024 * 1024;
+
+	MEMORYSTATUSEX status{.dwLength = sizeof status};
+	if (!GlobalMemoryStatusEx(&status))
+		return 1024ull * 1024 * 1024;
+	return status.ullAvailPhys / 2;
+}
+
 void FontGeneratorConfig::Save() const {
 	std::ofstream configFile(GetConfigPath());
 	nlohmann::json json;
@@ -10,10 +10,42 @@ struct FontGeneratorConfig {
 
 	std::string Language;
 
+	// Number of worker threads used while compiling; 0 means the number of hardware threads.
+	size_t WorkerThreads = 0;
+
+	// Memory that compiled textures may take at once while exporting; 0 means half of the physical memory available at the time.
+	// Limits how far compilation runs ahead of writing, how many layout trials run at once, and how many blocks of glyphs get
+	// rasterized at once for the glyph cache. A FontSet is always compiled entirely
+	// in memory before any of its pages get written, so a single FontSet that does not fit is still exported, over this limit.
+	size_t ExportMemoryLimitMB = 0;
+
+	// Keep rasterized glyphs of DirectWrite and FreeType fonts on disk, so that later exports can skip rendering them again.
+	bool UseGlyphCache = true;
+
+	// Keep compiled FontSets on disk, so that exporting a FontSet that has not changed skips compilation.
+	bool UseCompiledFontSetCache = true;
+
+	// Directory to store cached glyphs and compiled FontSets in; empty means %LOCALAPPDATA%\XivRes.FontGenerator\cache.
+	std::filesystem::path GlyphCacheDirectory;
+
+	// Upper bound of the total size of the cache directory; least recently used files are removed past it. 0 means unlimited.
+	size_t CacheSizeLimitMB = 2048;
+
+	// Make TTMP2 exports of the same input byte-identical, by listing files in TTMPL.mpl in a fixed order and clearing zip timestamps.
+	bool ReproducibleExports = false;
+
+	// Directories to look up fonts for the FreeType renderer from, before falling back to fonts installed in the system.
+	std::vector<std::filesystem::path> FontDirectories;
+
 	static const FontGeneratorConfig Default;
 
 	static std::filesystem::path GetConfigPath();
 
+	size_t GetWorkerThreadCount() const;
+
+	// Get the memory that compiled textures may take at once; see ExportMemoryLimitMB.
+	uint64_t GetExportMemoryBudget() const;
+
 	void Save() const;
 };
 
@@ -0,0 +1,362 @@
+#include "pch.h"
+#include "FontGeneratorConfig.h"
+#include "FontIndex.h"
+#include "MappedFileStream.h"
+
+App::FontIndex& App::FontIndex::GetInstance() {
+	static FontIndex s_instance;
+	return s_instance;
+}
+
+std::optional<App::FontIndex::FaceEntry> App::FontIndex::Find(const std::string& familyName, DWRITE_FONT_WEIGHT weight, DWRITE_FONT_STRETCH stretch, DWRITE_FONT_STYLE style) {
+	const auto lock = std::lock_guard(m_mtx);
+	RefreshIfChanged();
+
+	const auto it = m_families.find(xivres::util::unicode::convert<std::string>(familyName, &xivres::util::unicode::lower));
+	if (it == m_families.end())
+		return std::nullopt;
+
+	// Style matters the most, then stretch, and then weight.
+	const auto getDistance = [weight, stretch, style](const FaceEntry& face) {
+		return (face.Style == style ? 0 : 1000000)
+			+ std::abs(static_cast<int>(face.Stretch) - static_cast<int>(stretch)) * 1000
+			+ std::abs(static_cast<int>(face.Weight) - static_cast<int>(weight));
+	};
+	return *std::ranges::min_element(it->second, {}, getDistance);
+}
+
+void App::FontIndex::Refresh() {
+	const auto lock = std::lock_guard(m_mtx);
+	RefreshImpl();
+}
+
+std::filesystem::path App::FontIndex::GetIndexPath() {
+	return FontGeneratorConfig::GetConfigPath().parent_path() / "fontindex.json";
+}
+
+void App::FontIndex::RefreshIfChanged() {
+	if (m_indexedDirectories != g_config.FontDirectories) {
+		RefreshImpl();
+		return;
+	}
+
+	const auto now = std::chrono::steady_clock::now();
+	if (now - m_lastChangeCheck < ChangeCheckInterval)
+		return;
+
+	m_lastChangeCheck = now;
+	if (IsAnyChanged())
+		RefreshImpl();
+}
+
+bool App::FontIndex::IsAnyChanged() const {
+	std::error_code ec;
+	for (const auto& [path, lastWriteTime] : m_directoryWriteTimes) {
+		if (std::filesystem::last_write_time(path, ec).time_since_epoch().count() != lastWriteTime || ec)
+			return true;
+	}
+
+	// Files replaced in place do not change the write time of the directory.
+	for (const auto& [path, file] : m_files) {
+		if (std::filesystem::file_size(path, ec) != file.Size || ec)
+			return true;
+		if (std::filesystem::last_write_time(path, ec).time_since_epoch().count() != file.LastWriteTime || ec)
+			return true;
+	}
+
+	return false;
+}
+
+void App::FontIndex::RefreshImpl() {
+	if (!m_bLoaded) {
+		m_bLoaded = true;
+		Load();
+	}
+
+	FT_Library library = nullptr;
+	const auto cleanup = xivres::util::on_dtor([&library]() {
+		if (library)
+			FT_Done_FreeType(library);
+	});
+
+	auto bChanged = false;
+	std::map<std::filesystem::path, FileEntry> files;
+	m_directoryWriteTimes.clear();
+	m_lastChangeCheck = std::chrono::steady_clock::now();
+	for (const auto& dir : g_config.FontDirectories) {
+		std::error_code ec;
+		if (const auto lastWriteTime = std::filesystem::last_write_time(dir, ec); !ec)
+			m_directoryWriteTimes.emplace(dir, lastWriteTime.time_since_epoch().count());
+
+		for (auto it = std::filesystem::recursive_directory_iterator(dir, std::filesystem::directory_options::skip_permission_denied, ec);
+			!ec && it != std::filesystem::recursive_directory_iterator();
+			it.increment(ec)) {
+			if (it->is_directory(ec)) {
+				if (const auto lastWriteTime = it->last_write_time(ec); !ec)
+					m_directoryWriteTimes.emplace(it->path(), lastWriteTime.time_since_epoch().count());
+				ec.clear();
+				continue;
+			}
+
+			if (!it->is_regular_file(ec))
+				continue;
+
+			const auto ext = xivres::util::unicode::convert<std::string>(it->path().extension().wstring(), &xivres::util::unicode::lower);
+			if (ext != ".ttf" && ext != ".otf" && ext != ".ttc" && ext != ".otc")
+				continue;
+
+			const auto& path = it->path();
+			if (files.contains(path))
+				continue;
+
+			const auto size = it->file_size(ec);
+			const auto lastWriteTime = static_cast<int64_t>(it->last_write_time(ec).time_since_epoch().count());
+			if (ec) {
+				ec.clear();
+				continue;
+			}
+
+			if (const auto prev = m_files.find(path); prev != m_files.end() && prev->second.Size == size && prev->second.LastWriteTime == lastWriteTime) {
+				files.emplace(path, std::move(prev->second));
+				continue;
+			}
+
+			if (!library && FT_Init_FreeType(&library))
+				return;
+
+			files.emplace(path, FileEntry{
+				.Size = size,
+				.LastWriteTime = lastWriteTime,
+				.Faces = ReadFaces(library, path),
+			});
+			bChanged = true;
+		}
+	}
+
+	// Some files have been removed.
+	if (files.size() != m_files.size())
+		bChanged = true;
+
+	m_files = std::move(files);
+	m_indexedDirectories = g_config.FontDirectories;
+
+	m_families.clear();
+	for (const auto& file : m_files | std::views::values) {
+		for (const auto& [familyNames, face] : file.Faces) {
+			for (const auto& familyName : familyNames)
+				m_families[xivres::util::unicode::convert<std::string>(familyName, &xivres::util::unicode::lower)].emplace_back(face);
+		}
+	}
+
+	if (bChanged) {
+		try {
+			Save();
+		} catch (const std::exception&) {
+			// The directories will be scanned again next time.
+		}
+	}
+}
+
+std::vector<std::pair<std::vector<std::string>, App::FontIndex::FaceEntry>> App::FontIndex::ReadFaces(FT_Library library, const std::filesystem::path& path) {
+	std::vector<std::pair<std::vector<std::string>, FaceEntry>> res;
+
+	std::shared_ptr<MappedFileStream> pStream;
+	try {
+		pStream = MappedFileStream::Open(path);
+	} catch (const std::system_error&) {
+		return res;
+	}
+
+	const auto data = pStream->as_span();
+
+	FT_Face face;
+	if (FT_New_Memory_Face(library, data.data(), static_cast<FT_Long>(data.size()), -1, &face))
+		return res;
+	const auto nFaces = face->num_faces;
+	FT_Done_Face(face);
+
+	for (FT_Long i = 0; i < nFaces; i++) {
+		if (FT_New_Memory_Face(library, data.data(), static_cast<FT_Long>(data.size()), i, &face))
+			continue;
+		const auto doneFace = xivres::util::on_dtor([face]() { FT_Done_Face(face); });
+
+		// DirectWrite accepts the legacy, typographic, and WWS family names in any language.
+		std::vector<std::string> familyNames;
+		for (FT_UInt j = 0, j_ = FT_Get_Sfnt_Name_Count(face); j < j_; j++) {
+			FT_SfntName name;
+			if (FT_Get_Sfnt_Name(face, j, &name))
+				continue;
+
+			if (name.name_id != TT_NAME_ID_FONT_FAMILY && name.name_id != TT_NAME_ID_TYPOGRAPHIC_FAMILY && name.name_id != TT_NAME_ID_WWS_FAMILY)
+				continue;
+
+			auto nameU8 = DecodeName(name);
+			if (!nameU8.empty() && std::ranges::find(familyNames, nameU8) == familyNames.end())
+				familyNames.emplace_back(std::move(nameU8));
+		}
+		if (familyNames.empty() && face->family_name)
+			familyNames.emplace_back(face->family_name);
+
+		FaceEntry entry{.Path = path, .Index = static_cast<int>(i)};
+		if (const auto pOs2 = static_cast<const TT_OS2*>(FT_Get_Sfnt_Table(face, FT_SFNT_OS2)); pOs2 && pOs2->version != 0xFFFF) {
+			entry.Weight = static_cast<DWRITE_FONT_WEIGHT>(std::clamp<int>(pOs2->usWeightClass, 1, 999));
+			entry.Stretch = static_cast<DWRITE_FONT_STRETCH>(std::clamp<int>(pOs2->usWidthClass, 1, 9));
+			if (pOs2->fsSelection & (1 << 9))
+				entry.Style = DWRITE_FONT_STYLE_OBLIQUE;
+			else if (pOs2->fsSelection & (1 << 0))
+				entry.Style = DWRITE_FONT_STYLE_ITALIC;
+		} else {
+			if (face->style_flags & FT_STYLE_FLAG_BOLD)
+				entry.Weight = DWRITE_FONT_WEIGHT_BOLD;
+			if (face->style_flags & FT_STYLE_FLAG_ITALIC)
+				entry.Style = DWRITE_FONT_STYLE_ITALIC;
+		}
+
+		res.emplace_back(std::move(familyNames), std::move(entry));
+	}
+
+	return res;
+}
+
+std::string App::FontIndex::DecodeName(const FT_SfntName& name) {
+	const auto decodeUtf16Be = [&name]() {
+		std::u32string res;
+		for (FT_UInt i = 0; i + 1 < name.string_len; i += 2) {
+			auto c = static_cast<char32_t>((name.string[i] << 8) | name.string[i + 1]);
+			if (0xD800 <= c && c < 0xDC00 && i + 3 < name.string_len) {
+				const auto low = static_cast<char32_t>((name.string[i + 2] << 8) | name.string[i + 3]);
+				if (0xDC00 <= low && low < 0xE000) {
+					c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+					i += 2;
+				}
+			}
+			res.push_back(c);
+		}
+		return xivres::util::unicode::convert<std::string>(res);
+	};
+
+	const auto decodeCodePage = [](UINT codePage, std::string_view bytes) -> std::string {
+		if (bytes.empty())
+			return {};
+
+		std::wstring res(bytes.size(), L'\0');
+		res.resize(MultiByteToWideChar(codePage, 0, bytes.data(), static_cast<int>(bytes.size()), res.data(), static_cast<int>(res.size())));
+		return xivres::util::unicode::convert<std::string>(res);
+	};
+
+	// Legacy Windows encodings store each character in a 16-bit big endian unit; single-byte characters have a zero high byte.
+	const auto decodeMicrosoftLegacy = [&name, &decodeCodePage](UINT codePage) {
+		std::string bytes;
+		for (FT_UInt i = 0; i + 1 < name.string_len; i += 2) {
+			if (name.string[i])
+				bytes.push_back(static_cast<char>(name.string[i]));
+			bytes.push_back(static_cast<char>(name.string[i + 1]));
+		}
+		return decodeCodePage(codePage, bytes);
+	};
+
+	const auto bytes = std::string_view(reinterpret_cast<const char*>(name.string), name.string_len);
+	switch (name.platform_id) {
+		case TT_PLATFORM_APPLE_UNICODE:
+			return decodeUtf16Be();
+
+		case TT_PLATFORM_MICROSOFT:
+			switch (name.encoding_id) {
+				case TT_MS_ID_SYMBOL_CS:
+				case TT_MS_ID_UNICODE_CS:
+				case TT_MS_ID_UCS_4:
+					return decodeUtf16Be();
+				case TT_MS_ID_SJIS:
+					return decodeMicrosoftLegacy(932);
+				case TT_MS_ID_PRC:
+					return decodeMicrosoftLegacy(936);
+				case TT_MS_ID_BIG_5:
+					return decodeMicrosoftLegacy(950);
+				case TT_MS_ID_WANSUNG:
+					return decodeMicrosoftLegacy(949);
+				case TT_MS_ID_JOHAB:
+					return decodeMicrosoftLegacy(1361);
+			}
+			return {};
+
+		case TT_PLATFORM_MACINTOSH:
+			switch (name.encoding_id) {
+				case TT_MAC_ID_ROMAN:
+					return decodeCodePage(10000, bytes);
+				case TT_MAC_ID_JAPANESE:
+					return decodeCodePage(10001, bytes);
+				case TT_MAC_ID_TRADITIONAL_CHINESE:
+					return decodeCodePage(10002, bytes);
+				case TT_MAC_ID_KOREAN:
+					return decodeCodePage(10003, bytes);
+				case TT_MAC_ID_SIMPLIFIED_CHINESE:
+					return decodeCodePage(10008, bytes);
+			}
+			return {};
+	}
+
+	return {};
+}
+
+void App::FontIndex::Load() {
+	try {
+		std::ifstream in(GetIndexPath());
+		if (!in)
+			return;
+
+		nlohmann::json json;
+		in >> json;
+		if (json.value<uint32_t>("version", 0) != IndexVersion)
+			return;
+
+		for (const auto& file : json.at("files")) {
+			const std::filesystem::path path = xivres::util::unicode::convert<std::wstring>(file.at("path").get<std::string>());
+
+			FileEntry entry{
+				.Size = file.at("size").get<uint64_t>(),
+				.LastWriteTime = file.at("lastWriteTime").get<int64_t>(),
+			};
+			for (const auto& face : file.at("faces")) {
+				entry.Faces.emplace_back(face.at("families").get<std::vector<std::string>>(), FaceEntry{
+					.Path = path,
+					.Index = face.at("index").get<int>(),
+					.Weight = static_cast<DWRITE_FONT_WEIGHT>(face.at("weight").get<int>()),
+					.Stretch = static_cast<DWRITE_FONT_STRETCH>(face.at("stretch").get<int>()),
+					.Style = static_cast<DWRITE_FONT_STYLE>(face.at("style").get<int>()),
+				});
+			}
+			m_files.emplace(path, std::move(entry));
+		}
+	} catch (const std::exception&) {
+		// Index is broken; scan everything again.
+		m_files.clear();
+	}
+}
+
+void App::FontIndex::Save() const {
+	auto files = nlohmann::json::array();
+	for (const auto& [path, file] : m_files) {
+		auto faces = nlohmann::json::array();
+		for (const auto& [familyNames, face] : file.Faces) {
+			faces.emplace_back(nlohmann::json::object({
+				{"index", face.Index},
+				{"families", familyNames},
+				{"weight", static_cast<int>(face.Weight)},
+				{"stretch", static_cast<int>(face.Stretch)},
+				{"style", static_cast<int>(face.Style)},
+			}));
+		}
+
+		files.emplace_back(nlohmann::json::object({
+			{"path", xivres::util::unicode::convert<std::string>(path.wstring())},
+			{"size", file.Size},
+			{"lastWriteTime", file.LastWriteTime},
+			{"faces", std::move(faces)},
+		}));
+	}
+
+	std::ofstream out(GetIndexPath());
+	if (!out)
+		throw std::runtime_error("Failed to write font index");
+	out << nlohmann::json::object({{"version", IndexVersion}, {"files", std::move(files)}});
+}
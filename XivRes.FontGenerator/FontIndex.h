@@ -0,0 +1,70 @@
+#pragma once
+
+namespace App {
+	// Finds font files by family name, weight, stretch and style in the directories listed in FontGeneratorConfig::FontDirectories.
+	// What has been read from the font files is kept on disk, and only files that have changed since then get read again.
+	class FontIndex {
+	public:
+		struct FaceEntry {
+			std::filesystem::path Path;
+			int Index = 0;
+			DWRITE_FONT_WEIGHT Weight = DWRITE_FONT_WEIGHT_REGULAR;
+			DWRITE_FONT_STRETCH Stretch = DWRITE_FONT_STRETCH_NORMAL;
+			DWRITE_FONT_STYLE Style = DWRITE_FONT_STYLE_NORMAL;
+		};
+
+	private:
+		static constexpr uint32_t IndexVersion = 2;
+
+		struct FileEntry {
+			uint64_t Size = 0;
+			int64_t LastWriteTime = 0;
+
+			// Pairs of (family names, face).
+			std::vector<std::pair<std::vector<std::string>, FaceEntry>> Faces;
+		};
+
+		// Interval between checks on whether any indexed directory or file has changed.
+		static constexpr auto ChangeCheckInterval = std::chrono::seconds(2);
+
+		std::mutex m_mtx;
+		bool m_bLoaded = false;
+		std::optional<std::vector<std::filesystem::path>> m_indexedDirectories;
+		std::map<std::filesystem::path, FileEntry> m_files;
+
+		// Last write times of the scanned directories and their subdirectories, which change when files are added or removed.
+		std::map<std::filesystem::path, int64_t> m_directoryWriteTimes;
+		std::chrono::steady_clock::time_point m_lastChangeCheck;
+
+		// Faces keyed by lowercase family name.
+		std::map<std::string, std::vector<FaceEntry>> m_families;
+
+	public:
+		static FontIndex& GetInstance();
+
+		// Find the face closest to the given properties in the family, in the way DirectWrite matches fonts.
+		std::optional<FaceEntry> Find(const std::string& familyName, DWRITE_FONT_WEIGHT weight, DWRITE_FONT_STRETCH stretch, DWRITE_FONT_STYLE style);
+
+		// Scan the configured directories again for added, changed, and removed files.
+		void Refresh();
+
+		static std::filesystem::path GetIndexPath();
+
+	private:
+		// Scan again if the configured directories, or the files in them, have changed since the last scan.
+		void RefreshIfChanged();
+
+		bool IsAnyChanged() const;
+
+		void RefreshImpl();
+
+		static std::vector<std::pair<std::vector<std::string>, FaceEntry>> ReadFaces(FT_Library library, const std::filesystem::path& path);
+
+		// Decode a name record into UTF-8, or return an empty string if its encoding is not supported.
+		static std::string DecodeName(const FT_SfntName& name);
+
+		void Load();
+
+		void Save() const;
+	};
+}
@@ -0,0 +1,1084 @@
+﻿#include "pch.h"
+#include "FontDataCache.h"
+#include "FontGeneratorConfig.h"
+#include "FontSetExporter.h"
+#include "xivres/textools.h"
+#include "resource.h"
+
+// Writes are issued in large chunks, so that the file system can lay out the files sequentially.
+static constexpr size_t WriteBufferSize = 8 * 1048576;
+
+// Layouts tried by FontSetExporter::OptimizeLayout.
+static constexpr int LayoutTrialSideLengths[]{1024, 2048, 4096};
+static constexpr int LayoutTrialDiscardSteps[]{1, 2, 4, 8};
+
+// Number of textures the game can load for each texture file name format.
+static constexpr std::pair<std::string_view, size_t> TextureCountLimits[]{
+	{"font{}.tex", 7},
+	{"font_lobby{}.tex", 6},
+	{"font_krn_{}.tex", 10},
+	{"font_chn_{}.tex", 20},
+};
+
+// Lets a trial compilation be cancelled along with the layout search, without reporting its own progress.
+class LayoutTrialProgress : public App::ExportProgress {
+	const App::ExportProgress& m_parent;
+
+public:
+	LayoutTrialProgress(const App::ExportProgress& parent) : m_parent(parent) {}
+
+	void ThrowIfCancelled() const override {
+		m_parent.ThrowIfCancelled();
+	}
+
+	bool IsCancelled() const override {
+		return m_parent.IsCancelled();
+	}
+
+	void UpdateStatusMessage(std::wstring_view) override {}
+
+	void UpdateProgress(float) override {}
+};
+
+// Holds back the status of a FontSet compiled ahead while the previous one is being written, and passes it on once attached.
+class DeferredProgress : public App::ExportProgress {
+	App::ExportProgress& m_parent;
+
+	std::mutex m_mtx;
+	bool m_bAttached = false;
+	std::optional<std::wstring> m_statusMessage;
+	std::optional<float> m_progress;
+
+public:
+	DeferredProgress(App::ExportProgress& parent) : m_parent(parent) {}
+
+	void ThrowIfCancelled() const override {
+		m_parent.ThrowIfCancelled();
+	}
+
+	bool IsCancelled() const override {
+		return m_parent.IsCancelled();
+	}
+
+	void UpdateStatusMessage(std::wstring_view s) override {
+		const auto lock = std::lock_guard(m_mtx);
+		if (m_bAttached)
+			m_parent.UpdateStatusMessage(s);
+		else
+			m_statusMessage = s;
+	}
+
+	void UpdateProgress(float progress) override {
+		const auto lock = std::lock_guard(m_mtx);
+		if (m_bAttached)
+			m_parent.UpdateProgress(progress);
+		else
+			m_progress = progress;
+	}
+
+	// Show the latest status held back so far, and pass further updates on as they come.
+	void Attach() {
+		const auto lock = std::lock_guard(m_mtx);
+		m_bAttached = true;
+		if (m_statusMessage)
+			m_parent.UpdateStatusMessage(*m_statusMessage);
+		if (m_progress)
+			m_parent.UpdateProgress(*m_progress);
+	}
+};
+
+static const char* GetPackerStageName(xivres::fontgen::fontdata_packer::progress_status_t stage) {
+	switch (stage) {
+		case xivres::fontgen::fontdata_packer::progress_status_t::prepare_source_fonts:
+			return "Prepare source fonts";
+		case xivres::fontgen::fontdata_packer::progress_status_t::prepare_target_fonts:
+			return "Prepare target fonts";
+		case xivres::fontgen::fontdata_packer::progress_status_t::discover_glyphs:
+			return "Discover glyphs";
+		case xivres::fontgen::fontdata_packer::progress_status_t::measure_glyphs:
+			return "Measure glyphs";
+		case xivres::fontgen::fontdata_packer::progress_status_t::layout_and_draw:
+			return "Layout and draw";
+		default:
+			return "Unknown";
+	}
+}
+
+App::FontSetExporter::FontSetExporter(Structs::MultiFontSet& multiFontSet, ExportProgress& progress)
+	: m_multiFontSet(multiFontSet)
+	, m_progress(progress) {
+	if (g_config.UseGlyphCache || g_config.UseCompiledFontSetCache)
+		m_cache = FontDataCache::Open(g_config.GlyphCacheDirectory.empty() ? FontDataCache::GetDefaultDirectory() : g_config.GlyphCacheDirectory);
+}
+
+void App::FontSetExporter::SetTraceRecorder(std::shared_ptr<TraceRecorder> trace) {
+	m_trace = std::move(trace);
+}
+
+App::FontSetExporter::CompiledFontSet App::FontSetExporter::Compile(Structs::FontSet& fontSet) {
+	return Compile(fontSet, m_progress);
+}
+
+App::FontSetExporter::CompiledFontSet App::FontSetExporter::Compile(Structs::FontSet& fontSet, ExportProgress& progress) {
+	const auto compileTrace = TraceRecorder::Scope(m_trace.get(), "Compile", "compile", nlohmann::json::object({{"texture", fontSet.TexFilenameFormat}}));
+
+	std::optional<uint64_t> cacheKey;
+	if (m_cache && g_config.UseCompiledFontSetCache) {
+		const auto trace = TraceRecorder::Scope(m_trace.get(), "Look up compiled cache", "compile");
+		progress.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_COMPILEDCACHE));
+		cacheKey = m_cache->GetFontSetKey(fontSet);
+		if (cacheKey) {
+			if (auto cached = m_cache->Load(*cacheKey); cached && cached->first.size() == fontSet.Faces.size() && !cached->second.empty()) {
+				UpdateExpectedTexCount(fontSet, cached->second.size());
+				const auto usedTextureCount = GetUsedTextureCount(cached->second);
+				{
+					const auto lock = std::lock_guard(m_statisticsMtx);
+					m_statistics.TextureCount += cached->second.size();
+					m_statistics.UsedTextureCount += usedTextureCount;
+				}
+				return std::move(*cached);
+			}
+		}
+	}
+
+	{
+		const auto trace = TraceRecorder::Scope(m_trace.get(), "Load fonts", "compile");
+		progress.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_LOADFONTS));
+		fontSet.ConsolidateFonts();
+	}
+
+	// Cached glyphs and shared wrapped fonts get set into the elements below; do that on a copy, so that the FontSet being edited
+	// keeps drawing its previews with the fonts made by its own renderers.
+	Structs::FontSet compiling{
+		.TexFilenameFormat = fontSet.TexFilenameFormat,
+		.DiscardStep = fontSet.DiscardStep,
+		.SideLength = fontSet.SideLength,
+		.ExpectedTexCount = fontSet.ExpectedTexCount,
+	};
+	for (const auto& pFace : fontSet.Faces)
+		compiling.Faces.emplace_back(std::make_unique<Structs::Face>(*pFace));
+
+	xivres::util::thread_pool::pool pool(g_config.GetWorkerThreadCount());
+
+	// Fonts that the wrapped fonts are made from, keyed by FaceElement::GetBaseFontKey.
+	std::map<std::string, std::shared_ptr<xivres::fontgen::fixed_size_font>> sourceFonts;
+	if (m_cache && g_config.UseGlyphCache) {
+		const auto trace = TraceRecorder::Scope(m_trace.get(), "Load cached glyphs", "compile");
+		progress.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_GLYPHCACHE));
+
+		std::map<std::string, std::pair<const Structs::FaceElement*, std::vector<std::pair<char32_t, char32_t>>>> requests;
+		for (const auto& pFace : compiling.Faces) {
+			for (const auto& pElem : pFace->Elements) {
+				auto& [pElemFirst, ranges] = requests[pElem->GetBaseFontKey()];
+				if (!pElemFirst)
+					pElemFirst = pElem.get();
+				ranges.insert(ranges.end(), pElem->WrapModifiers.Codepoints.begin(), pElem->WrapModifiers.Codepoints.end());
+				for (const auto& [from, to] : pElem->WrapModifiers.CodepointReplacements) {
+					ranges.emplace_back(from, from);
+					ranges.emplace_back(to, to);
+				}
+			}
+		}
+
+		xivres::util::thread_pool::task_waiter<std::pair<std::string, std::shared_ptr<xivres::fontgen::fixed_size_font>>> waiter(pool);
+		for (auto& [key, request] : requests) {
+			auto& [pElem, ranges] = request;
+
+			// Sort and merge ranges, so that the same set of codepoints always makes the same cache key.
+			std::ranges::sort(ranges);
+			std::vector<std::pair<char32_t, char32_t>> merged;
+			for (const auto& [c1, c2] : ranges) {
+				if (!merged.empty() && c1 <= merged.back().second + 1)
+					merged.back().second = (std::max)(merged.back().second, c2);
+				else
+					merged.emplace_back(c1, c2);
+			}
+			ranges = std::move(merged);
+
+			waiter.submit([this, &key, &request](auto&) -> std::pair<std::string, std::shared_ptr<xivres::fontgen::fixed_size_font>> {
+				if (IsCancelled())
+					return {key, nullptr};
+
+				const auto trace = TraceRecorder::Scope(m_trace.get(), "Load cached glyphs of font", "compile", nlohmann::json::object({{"font", request.first->Lookup.Name}}));
+				return {key, m_cache->LoadBaseFont(*request.first, request.second)};
+			});
+		}
+
+		for (std::optional<std::pair<std::string, std::shared_ptr<xivres::fontgen::fixed_size_font>>> res; (res = waiter.get());)
+			sourceFonts.emplace(std::move(*res));
+		ThrowIfCancelled();
+
+		// Rasterize the missing ones one font at a time from here; each of them spreads its blocks of glyphs over the pool.
+		for (auto& [key, pFont] : sourceFonts) {
+			if (pFont)
+				continue;
+
+			ThrowIfCancelled();
+			const auto& [pElem, ranges] = requests.at(key);
+			const auto trace = TraceRecorder::Scope(m_trace.get(), "Rasterize glyphs of font", "compile", nlohmann::json::object({{"font", pElem->Lookup.Name}}));
+			pFont = m_cache->RasterizeBaseFont(*pElem, ranges, pool);
+		}
+
+		for (const auto& pFace : compiling.Faces) {
+			for (const auto& pElem : pFace->Elements) {
+				if (const auto& pFont = sourceFonts.at(pElem->GetBaseFontKey()); pFont != pElem->GetBaseFont())
+					pElem->SetWrappedFontSource(pFont);
+			}
+		}
+	} else {
+		for (const auto& pFace : compiling.Faces) {
+			for (const auto& pElem : pFace->Elements)
+				sourceFonts.emplace(pElem->GetBaseFontKey(), pElem->GetBaseFont());
+		}
+	}
+	compiling.ShareWrappedFonts();
+
+	{
+		const auto trace = TraceRecorder::Scope(m_trace.get(), "Resolve kerning pairs", "compile");
+		progress.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_KERNINGPAIRS));
+
+		// Resolve kerning pairs of distinct source fonts and then of wrapped fonts first, so that a face merged from several large fonts
+		// gets spread across workers, instead of one worker going through all of them when building the merged kerning table.
+		const auto warmUpKerningPairs = [this, &pool](const std::vector<std::shared_ptr<xivres::fontgen::fixed_size_font>>& fonts) {
+			xivres::util::thread_pool::task_waiter<size_t> waiter(pool);
+			for (const auto& pFont : fonts) {
+				waiter.submit([pFont, this](auto&) -> size_t {
+					if (IsCancelled())
+						return 0;
+					return pFont->all_kerning_pairs().size();
+				});
+			}
+			while (waiter.get()) {}
+			ThrowIfCancelled();
+		};
+
+		{
+			std::vector<std::shared_ptr<xivres::fontgen::fixed_size_font>> fonts;
+			for (const auto& pFont : sourceFonts | std::views::values) {
+				if (std::ranges::find(fonts, pFont) == fonts.end())
+					fonts.emplace_back(pFont);
+			}
+			warmUpKerningPairs(fonts);
+
+			fonts.clear();
+			for (const auto& pFace : compiling.Faces) {
+				for (const auto& pElem : pFace->Elements)
+					fonts.emplace_back(pElem->GetWrappedFont());
+			}
+			warmUpKerningPairs(fonts);
+		}
+
+		xivres::util::thread_pool::task_waiter<std::pair<Structs::Face*, size_t>> waiter(pool);
+		for (auto& pFace : compiling.Faces) {
+			waiter.submit([pFace = pFace.get(), this](auto&) -> std::pair<Structs::Face*, size_t> {
+				if (IsCancelled())
+					return {pFace, 0};
+				return {pFace, pFace->GetMergedFont()->all_kerning_pairs().size()};
+			});
+		}
+
+		std::vector<std::string> tooManyKernings;
+		size_t nTotalKerns = 0;
+		for (std::optional<std::pair<Structs::Face*, size_t>> res; (res = waiter.get());) {
+			const auto& [pFace, nKerns] = *res;
+			if (nKerns >= 65536)
+				tooManyKernings.emplace_back(std::format("\n{}: {}", pFace->Name, nKerns));
+			nTotalKerns += nKerns;
+		}
+		if (!tooManyKernings.empty()) {
+			std::ranges::sort(tooManyKernings);
+			std::wstring s(GetStringResource(IDS_ERROR_KERNINGTABLETOOLARGE));
+			for (const auto& s2 : tooManyKernings)
+				s += xivres::util::unicode::convert<std::wstring>(s2);
+			throw WException(s);
+		}
+
+		const auto lock = std::lock_guard(m_statisticsMtx);
+		m_statistics.KerningPairCount += nTotalKerns;
+	}
+	ThrowIfCancelled();
+
+	xivres::fontgen::fontdata_packer packer;
+	packer.set_discard_step(compiling.DiscardStep);
+	packer.set_side_length(compiling.SideLength);
+
+	for (auto& pFace : compiling.Faces)
+		packer.add_font(pFace->GetMergedFont());
+
+	packer.compile();
+
+	// Poll more often while tracing, so that the stages are timed closer to when they actually change.
+	const auto pollInterval = m_trace ? std::chrono::milliseconds(5) : std::chrono::milliseconds(200);
+	std::optional<xivres::fontgen::fontdata_packer::progress_status_t> lastStage;
+	TraceRecorder::Scope stageTrace;
+	while (!packer.wait(pollInterval)) {
+		ThrowIfCancelled();
+
+		const auto stage = packer.progress_description();
+		if (m_trace && stage != lastStage) {
+			lastStage = stage;
+			stageTrace = TraceRecorder::Scope(m_trace.get(), GetPackerStageName(stage), "packer");
+		}
+
+		switch (stage) {
+			case xivres::fontgen::fontdata_packer::progress_status_t::prepare_source_fonts:
+				progress.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_PREPARESOURCEFONTS));
+				break;
+			case xivres::fontgen::fontdata_packer::progress_status_t::prepare_target_fonts:
+				progress.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_PREPARETARGETFONTS));
+				break;
+			case xivres::fontgen::fontdata_packer::progress_status_t::discover_glyphs:
+				progress.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_DISCOVERGLYPHS));
+				break;
+			case xivres::fontgen::fontdata_packer::progress_status_t::measure_glyphs:
+				progress.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_MEASUREGLYPHS));
+				break;
+			case xivres::fontgen::fontdata_packer::progress_status_t::layout_and_draw:
+				progress.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_LAYOUTANDDRAW));
+				break;
+		}
+		progress.UpdateProgress(packer.progress_scaled());
+	}
+	stageTrace.End();
+	if (const auto err = packer.get_error_if_failed(); !err.empty())
+		throw std::runtime_error(err);
+
+	const auto& fdts = packer.compiled_fontdatas();
+	const auto& mips = packer.compiled_mipmap_streams();
+	if (mips.empty())
+		throw std::runtime_error("未生成任何多级纹理");
+
+	UpdateExpectedTexCount(fontSet, mips.size());
+	const auto usedTextureCount = GetUsedTextureCount(mips);
+	{
+		const auto lock = std::lock_guard(m_statisticsMtx);
+		for (const auto& pFace : compiling.Faces)
+			m_statistics.GlyphCount += pFace->GetMergedFont()->all_codepoints().size();
+		m_statistics.TextureCount += mips.size();
+		m_statistics.UsedTextureCount += usedTextureCount;
+	}
+
+	auto res = std::make_pair(fdts, mips);
+	if (cacheKey && m_bStoreCompiledCache) {
+		const auto trace = TraceRecorder::Scope(m_trace.get(), "Store compiled cache", "compile");
+		try {
+			m_cache->Store(*cacheKey, res, pool);
+		} catch (const std::exception&) {
+			// Failing to write the cache is fine; the FontSet will be compiled again next time.
+		}
+	}
+	return res;
+}
+
+void App::FontSetExporter::ForEachCompiledFontSet(const std::function<void(Structs::FontSet&, CompiledFontSet&&)>& cb) {
+	const auto& fontSets = m_multiFontSet.FontSets;
+	if (fontSets.empty())
+		return;
+
+	const auto memoryBudget = g_config.GetExportMemoryBudget();
+
+	std::future<CompiledFontSet> next;
+	std::unique_ptr<DeferredProgress> nextProgress;
+	const auto waitForPending = xivres::util::on_dtor([this, &next]() {
+		if (!next.valid())
+			return;
+
+		m_bAbortPipeline = true;
+		next.wait();
+		m_bAbortPipeline = false;
+	});
+
+	auto current = Compile(*fontSets[0]);
+	for (size_t i = 0; i < fontSets.size(); i++) {
+		const auto bHasNext = i + 1 < fontSets.size();
+		if (bHasNext) {
+			// Size of the next FontSet is not known until it has been compiled; go by how many textures it had the last time.
+			const auto usage = GetMemoryUsage(current)
+				+ EstimateMemoryUsage(fontSets[i + 1]->SideLength, static_cast<size_t>((std::max)(1, fontSets[i + 1]->ExpectedTexCount)));
+			if (usage <= memoryBudget) {
+				nextProgress = std::make_unique<DeferredProgress>(m_progress);
+				next = std::async(std::launch::async, [this, &fontSet = *fontSets[i + 1], &progress = *nextProgress]() { return Compile(fontSet, progress); });
+			}
+		}
+
+		cb(*fontSets[i], std::move(current));
+
+		if (bHasNext) {
+			if (next.valid()) {
+				nextProgress->Attach();
+				current = next.get();
+			} else {
+				current = Compile(*fontSets[i + 1]);
+			}
+		}
+	}
+}
+
+App::FontSetExporter::LayoutSearchResult App::FontSetExporter::OptimizeLayout(Structs::FontSet& fontSet) {
+	const auto searchTrace = TraceRecorder::Scope(m_trace.get(), "Optimize layout", "layout", nlohmann::json::object({{"texture", fontSet.TexFilenameFormat}}));
+
+	LayoutSearchResult res;
+	res.TextureCountLimit = GetTextureCountLimit(fontSet);
+	for (const auto sideLength : LayoutTrialSideLengths) {
+		for (const auto discardStep : LayoutTrialDiscardSteps)
+			res.Trials.emplace_back(LayoutTrial{.SideLength = sideLength, .DiscardStep = discardStep});
+	}
+
+	// Load the fonts once here, so that the copies made for each trial share them.
+	{
+		const auto trace = TraceRecorder::Scope(m_trace.get(), "Load fonts", "layout");
+		m_progress.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_LOADFONTS));
+		fontSet.ConsolidateFonts();
+	}
+
+	const auto memoryBudget = g_config.GetExportMemoryBudget();
+	const auto nMaxParallel = (std::min)(res.Trials.size(), g_config.GetWorkerThreadCount());
+
+	const auto texFilenameFormatW = xivres::util::unicode::convert<std::wstring>(fontSet.TexFilenameFormat);
+	m_progress.UpdateStatusMessage(std::vformat(GetStringResource(IDS_EXPORTPROGRESS_LAYOUTTRIALS), std::make_wformat_args(texFilenameFormatW)));
+	m_progress.UpdateProgress(0.f);
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	size_t nTrialsRunning = 0;
+	size_t nTrialsDone = 0;
+	uint64_t memoryInUse = 0;
+
+	// Largest area taken by the glyphs in any finished trial, in pixels of a plane (color channel).
+	std::optional<double> glyphArea;
+
+	// Every trial holds the textures of a whole FontSet at once; the glyphs take about the same area whichever layout is used.
+	// Leave room for one more texture, for the packing coming out worse with the layout.
+	const auto estimateTrialMemory = [&glyphArea](int sideLength) {
+		const auto texCount = static_cast<size_t>(std::ceil(*glyphArea / (static_cast<double>(sideLength) * sideLength))) + 1;
+		return EstimateMemoryUsage(sideLength, texCount);
+	};
+
+	std::vector<std::future<void>> workers;
+	auto lock = std::unique_lock(mtx);
+	const auto waitAndReport = [&]() {
+		cv.wait_for(lock, std::chrono::milliseconds(200));
+		const auto progress = static_cast<float>(nTrialsDone) / static_cast<float>(res.Trials.size());
+		lock.unlock();
+		m_progress.UpdateProgress(progress);
+		lock.lock();
+	};
+
+	for (size_t index = 0; index < res.Trials.size() && !IsCancelled(); index++) {
+		const auto sideLength = res.Trials[index].SideLength;
+		while (nTrialsRunning && !IsCancelled()
+			&& (!glyphArea || nTrialsRunning >= nMaxParallel || memoryInUse + estimateTrialMemory(sideLength) > memoryBudget))
+			waitAndReport();
+		if (IsCancelled())
+			break;
+
+		const auto memory = glyphArea ? estimateTrialMemory(sideLength) : 0;
+		memoryInUse += memory;
+		nTrialsRunning++;
+		workers.emplace_back(std::async(std::launch::async, [this, &fontSet, &trial = res.Trials[index], memory, &mtx, &cv, &nTrialsRunning, &nTrialsDone, &memoryInUse, &glyphArea]() {
+			const auto release = xivres::util::on_dtor([&]() {
+				const auto lock = std::lock_guard(mtx);
+				if (trial.TextureCount)
+					glyphArea = (std::max)(glyphArea.value_or(0.), trial.UsedTextureCount * trial.SideLength * trial.SideLength);
+				memoryInUse -= memory;
+				nTrialsRunning--;
+				nTrialsDone++;
+				cv.notify_all();
+			});
+			RunLayoutTrial(fontSet, trial);
+		}));
+	}
+
+	while (nTrialsRunning)
+		waitAndReport();
+	lock.unlock();
+	for (auto& worker : workers)
+		worker.get();
+	ThrowIfCancelled();
+
+	for (size_t i = 0; i < res.Trials.size(); i++) {
+		const auto& trial = res.Trials[i];
+		if (!trial.TextureCount || trial.TextureCount > res.TextureCountLimit)
+			continue;
+
+		if (!res.Chosen) {
+			res.Chosen = i;
+			continue;
+		}
+
+		const auto& best = res.Trials[*res.Chosen];
+		if (trial.GetTextureBytes() < best.GetTextureBytes()
+			|| (trial.GetTextureBytes() == best.GetTextureBytes() && trial.DiscardStep > best.DiscardStep))
+			res.Chosen = i;
+	}
+
+	if (res.Chosen) {
+		const auto& chosen = res.Trials[*res.Chosen];
+		res.bChanged = fontSet.SideLength != chosen.SideLength
+			|| fontSet.DiscardStep != chosen.DiscardStep
+			|| fontSet.ExpectedTexCount != static_cast<int>(chosen.TextureCount);
+		fontSet.SideLength = chosen.SideLength;
+		fontSet.DiscardStep = chosen.DiscardStep;
+		UpdateExpectedTexCount(fontSet, chosen.TextureCount);
+	}
+
+	return res;
+}
+
+size_t App::FontSetExporter::GetTextureCountLimit(const Structs::FontSet& fontSet) const {
+	const auto getLimit = [](std::string_view texFilenameFormat) {
+		for (const auto& [format, limit] : TextureCountLimits) {
+			if (format == texFilenameFormat)
+				return limit;
+		}
+		return TextureCountLimits[0].second;
+	};
+
+	auto res = getLimit(fontSet.TexFilenameFormat);
+
+	// Textures exported under other names have to fit within the limits of those names too.
+	for (const auto& alias : GetAliases(fontSet, 1) | std::views::values) {
+		if (alias.ends_with("1.tex"))
+			res = (std::min)(res, getLimit(alias.substr(0, alias.size() - 5) + "{}.tex"));
+	}
+
+	return res;
+}
+
+void App::FontSetExporter::ExportToTTMP(const std::filesystem::path& path, CompressionMode compressionMode) {
+	xivres::textools::simple_ttmp2_writer writer(path);
+
+	writer.begin_packed(compressionMode == CompressionMode::CompressAfterPacking ? Z_BEST_COMPRESSION : Z_NO_COMPRESSION);
+	ForEachCompiledFontSet([&](Structs::FontSet& fontSet, CompiledFontSet&& compiled) {
+		auto [fdts, mips] = std::move(compiled);
+		const auto texCount = mips.size();
+		const auto compressionLevel = compressionMode == CompressionMode::CompressWhilePacking ? Z_BEST_COMPRESSION : Z_NO_COMPRESSION;
+
+		auto& modsList = writer.ttmpl().SimpleModsList;
+		const auto beginIndex = modsList.size();
+
+		WritePackedInOrder(
+			fdts.size() + mips.size(),
+			compressionLevel != Z_NO_COMPRESSION,
+			[&](size_t index) -> PackedEntry {
+				if (index < fdts.size()) {
+					auto targetFileName = std::format("common/font/{}.fdt", fontSet.Faces[index]->Name);
+					auto pPacked = std::make_shared<xivres::compressing_packed_stream<xivres::standard_compressing_packer>>(targetFileName, std::move(fdts[index]), compressionLevel);
+					return {std::move(targetFileName), std::move(pPacked)};
+				}
+
+				const auto i = index - fdts.size();
+				const auto i1 = i + 1;
+				auto targetFileName = std::format("common/font/{}", std::vformat(fontSet.TexFilenameFormat, std::make_format_args(i1)));
+
+				// Let the packed stream hold the last reference to the page, so that the page is freed once it has been written.
+				const auto mip = std::move(mips[i]);
+				auto textureOne = std::make_shared<xivres::texture::stream>(mip->Type, mip->Width, mip->Height, 1, 1, 1);
+				textureOne->set_mipmap(0, 0, mip);
+
+				auto pPacked = std::make_shared<xivres::compressing_packed_stream<xivres::texture_compressing_packer>>(targetFileName, std::move(textureOne), compressionLevel);
+				return {std::move(targetFileName), std::move(pPacked)};
+			},
+			[&](const PackedEntry& entry) {
+				const auto targetFileNameW = xivres::util::unicode::convert<std::wstring>(entry.first);
+				m_progress.UpdateStatusMessage(
+					std::vformat(
+						GetStringResource(IDS_EXPORTPROGRESS_WRITINGFILE),
+						std::make_wformat_args(targetFileNameW)));
+
+				writer.add_packed(*entry.second);
+			});
+
+		const auto endIndex = modsList.size();
+
+		for (const auto& [fileName, aliasName] : GetAliases(fontSet, texCount)) {
+			const auto sourceName = std::format("common/font/{}", fileName);
+			const auto it = std::find_if(modsList.begin() + beginIndex, modsList.begin() + endIndex, [&sourceName](const auto& mod) { return mod.Name == sourceName; });
+			if (it == modsList.begin() + endIndex)
+				continue;
+
+			xivres::textools::mods_json tmp = *it;
+			tmp.Name = std::format("common/font/{}", aliasName);
+			tmp.FullPath = xivres::util::unicode::convert<std::string>(tmp.Name, &xivres::util::unicode::lower);
+			modsList.push_back(std::move(tmp));
+		}
+	});
+
+	// Entries are listed FontSet by FontSet, each followed by its aliases; make the order depend only on the file names.
+	if (g_config.ReproducibleExports)
+		std::ranges::stable_sort(writer.ttmpl().SimpleModsList, {}, &xivres::textools::mods_json::FullPath);
+
+	writer.close();
+
+	if (g_config.ReproducibleExports)
+		ClearZipTimestamps(path);
+}
+
+void App::FontSetExporter::ExportToRaw(const std::filesystem::path& basePath) {
+	std::vector<char> buf(WriteBufferSize);
+
+	ForEachCompiledFontSet([&](Structs::FontSet& fontSet, CompiledFontSet&& compiled) {
+		auto [fdts, mips] = std::move(compiled);
+
+		m_progress.UpdateProgress(std::nanf(""));
+		m_progress.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_WRITINGTOFILES));
+
+		xivres::texture::stream textureOne(mips[0]->Type, mips[0]->Width, mips[0]->Height, 1, 1, 1);
+
+		for (size_t i = 0; i < mips.size(); i++) {
+			m_progress.ThrowIfCancelled();
+			textureOne.set_mipmap(0, 0, std::move(mips[i]));
+
+			const auto i1 = i + 1;
+			WriteStreamToFile(textureOne, basePath / std::vformat(fontSet.TexFilenameFormat, std::make_format_args(i1)), buf);
+		}
+
+		for (size_t i = 0; i < fdts.size(); i++) {
+			m_progress.ThrowIfCancelled();
+			WriteStreamToFile(*fdts[i], basePath / std::format("{}.fdt", fontSet.Faces[i]->Name), buf);
+		}
+
+		for (const auto& [fileName, aliasName] : GetAliases(fontSet, mips.size())) {
+			m_progress.ThrowIfCancelled();
+			const auto trace = TraceRecorder::Scope(m_trace.get(), "Create alias", "export", nlohmann::json::object({{"file", aliasName}}));
+			CreateAlias(basePath / fileName, basePath / aliasName);
+		}
+	});
+}
+
+uint64_t App::FontSetExporter::LayoutTrial::GetTextureBytes() const {
+	return static_cast<uint64_t>(TextureCount) * SideLength * SideLength * 4;
+}
+
+bool App::FontSetExporter::IsExpectedTexCountChanged() const {
+	return m_bExpectedTexCountChanged;
+}
+
+double App::FontSetExporter::GetUsedTextureCount(const std::vector<std::shared_ptr<xivres::texture::memory_mipmap_stream>>& mips) {
+	static constexpr size_t PlaneCount = 4;
+
+	double res = 0;
+	for (const auto& mip : mips) {
+		const auto width = static_cast<size_t>(mip->Width);
+		const auto height = static_cast<size_t>(mip->Height);
+		const auto bytes = mip->as_span<uint8_t>();
+		if (!width || !height)
+			continue;
+
+		// Font textures store 4 or 8 bits per plane.
+		const auto bytesPerPixel = bytes.size() / width / height;
+		if (bytesPerPixel != 2 && bytesPerPixel != 4) {
+			res += 1;
+			continue;
+		}
+
+		const auto bitsPerPlane = bytesPerPixel * 8 / PlaneCount;
+		const auto rowBytes = bytesPerPixel * width;
+		std::array<size_t, PlaneCount> usedRows{};
+		size_t nPlanesFound = 0;
+		for (auto y = height; y-- > 0 && nPlanesFound < PlaneCount;) {
+			// Combine every pixel in the row, to see which planes have anything in the row.
+			std::array<uint8_t, 4> acc{};
+			const auto row = bytes.subspan(y * rowBytes, rowBytes);
+			for (size_t i = 0; i < rowBytes; i++)
+				acc[i % bytesPerPixel] |= row[i];
+
+			uint32_t pixel = 0;
+			for (size_t i = 0; i < bytesPerPixel; i++)
+				pixel |= static_cast<uint32_t>(acc[i]) << (8 * i);
+
+			for (size_t plane = 0; plane < PlaneCount; plane++) {
+				if (!usedRows[plane] && ((pixel >> (plane * bitsPerPlane)) & ((1u << bitsPerPlane) - 1))) {
+					usedRows[plane] = y + 1;
+					nPlanesFound++;
+				}
+			}
+		}
+
+		for (const auto rows : usedRows)
+			res += static_cast<double>(rows) / static_cast<double>(height * PlaneCount);
+	}
+	return res;
+}
+
+App::FontSetExporter::Statistics App::FontSetExporter::GetStatistics() const {
+	const auto lock = std::lock_guard(m_statisticsMtx);
+	return m_statistics;
+}
+
+void App::FontSetExporter::UpdateExpectedTexCount(Structs::FontSet& fontSet, size_t texCount) {
+	if (fontSet.ExpectedTexCount != static_cast<int>(texCount)) {
+		fontSet.ExpectedTexCount = static_cast<int>(texCount);
+		m_bExpectedTexCountChanged = true;
+	}
+}
+
+bool App::FontSetExporter::IsCancelled() const {
+	return m_bAbortPipeline || m_progress.IsCancelled();
+}
+
+void App::FontSetExporter::ThrowIfCancelled() const {
+	m_progress.ThrowIfCancelled();
+	if (m_bAbortPipeline)
+		throw PipelineAbortedError();
+}
+
+void App::FontSetExporter::RunLayoutTrial(const Structs::FontSet& fontSet, LayoutTrial& trial) const {
+	const auto trace = TraceRecorder::Scope(m_trace.get(), "Layout trial", "layout", nlohmann::json::object({
+		{"texture", fontSet.TexFilenameFormat},
+		{"sideLength", trial.SideLength},
+		{"discardStep", trial.DiscardStep},
+	}));
+
+	Structs::FontSet trialFontSet{
+		.TexFilenameFormat = fontSet.TexFilenameFormat,
+		.DiscardStep = trial.DiscardStep,
+		.SideLength = trial.SideLength,
+		.ExpectedTexCount = fontSet.ExpectedTexCount,
+	};
+	for (const auto& pFace : fontSet.Faces)
+		trialFontSet.Faces.emplace_back(std::make_unique<Structs::Face>(*pFace));
+
+	// Each trial gets its own exporter, so that trials do not count towards the statistics or the expected texture count of this one.
+	// Layouts that end up not being chosen are not worth keeping in the compiled cache.
+	LayoutTrialProgress progress(m_progress);
+	FontSetExporter exporter(m_multiFontSet, progress);
+	exporter.SetTraceRecorder(m_trace);
+	exporter.m_bStoreCompiledCache = false;
+
+	const auto begin = std::chrono::steady_clock::now();
+	try {
+		const auto [fdts, mips] = exporter.Compile(trialFontSet);
+		trial.TextureCount = mips.size();
+		trial.UsedTextureCount = GetUsedTextureCount(mips);
+	} catch (const WException& e) {
+		trial.Error = e.what();
+	} catch (const std::exception& e) {
+		trial.Error = xivres::util::unicode::convert<std::wstring>(e.what());
+	}
+	trial.Duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin);
+}
+
+uint64_t App::FontSetExporter::EstimateMemoryUsage(int sideLength, size_t texCount) {
+	// Compiled textures are kept as 32bpp mipmaps until written.
+	return static_cast<uint64_t>(texCount) * sideLength * sideLength * 4;
+}
+
+uint64_t App::FontSetExporter::GetMemoryUsage(const CompiledFontSet& compiled) {
+	uint64_t res = 0;
+	for (const auto& fdt : compiled.first)
+		res += fdt->size();
+	for (const auto& mip : compiled.second)
+		res += mip->as_span<uint8_t>().size();
+	return res;
+}
+
+void App::FontSetExporter::WritePackedInOrder(size_t count, bool bCompressInParallel, const std::function<PackedEntry(size_t)>& createEntry, const std::function<void(const PackedEntry&)>& writeEntry) {
+	// Packed streams compress their whole content on first access and keep the result, so touching them from workers is enough.
+	// Each entry is compressed on its own, so the packed data stays the same as when compressed one after another.
+	const auto nWorkers = bCompressInParallel ? g_config.GetWorkerThreadCount() : 0;
+	const auto nMaxInFlight = (std::max<size_t>)(1, nWorkers * 2);
+
+	std::vector<PackedEntry> entries(count);
+	std::vector<bool> ready(count);
+
+	xivres::util::thread_pool::pool pool((std::max<size_t>)(1, nWorkers));
+	xivres::util::thread_pool::task_waiter<size_t> waiter(pool);
+	std::atomic_bool bAbort = false;
+	const auto waitForPending = xivres::util::on_dtor([&waiter, &bAbort]() {
+		bAbort = true;
+		while (waiter.get()) {}
+	});
+
+	size_t nextCreateIndex = 0;
+	for (size_t nextWriteIndex = 0; nextWriteIndex < count;) {
+		ThrowIfCancelled();
+
+		for (; nextCreateIndex < count && nextCreateIndex - nextWriteIndex < nMaxInFlight; nextCreateIndex++) {
+			entries[nextCreateIndex] = createEntry(nextCreateIndex);
+			if (!bCompressInParallel) {
+				ready[nextCreateIndex] = true;
+				continue;
+			}
+
+			waiter.submit([this, &bAbort, index = nextCreateIndex, &entry = entries[nextCreateIndex]](auto&) -> size_t {
+				if (!bAbort && !IsCancelled()) {
+					const auto trace = TraceRecorder::Scope(m_trace.get(), "Compress", "export", nlohmann::json::object({{"file", entry.first}}));
+					(void)entry.second->size();
+				}
+				return index;
+			});
+		}
+
+		if (!ready[nextWriteIndex]) {
+			m_progress.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_COMPRESSING));
+			ready[*waiter.get()] = true;
+			continue;
+		}
+
+		{
+			const auto trace = TraceRecorder::Scope(m_trace.get(), "Write", "export", nlohmann::json::object({{"file", entries[nextWriteIndex].first}}));
+			writeEntry(entries[nextWriteIndex]);
+		}
+		entries[nextWriteIndex] = {};
+		nextWriteIndex++;
+		m_progress.UpdateProgress(static_cast<float>(nextWriteIndex) / static_cast<float>(count));
+	}
+}
+
+std::vector<std::pair<std::string, std::string>> App::FontSetExporter::GetAliases(const Structs::FontSet& fontSet, size_t texCount) const {
+	std::vector<std::pair<std::string, std::string>> res;
+	if (fontSet.TexFilenameFormat != "font{}.tex")
+		return res;
+
+	const auto addAxisAliases = [&](const char* fdtPrefix, const char* texPrefix) {
+		for (const auto& pFace : fontSet.Faces) {
+			for (const auto size : {12, 14, 18, 36}) {
+				if (pFace->Name == std::format("AXIS_{}", size))
+					res.emplace_back(std::format("{}.fdt", pFace->Name), std::format("{}{}0.fdt", fdtPrefix, size));
+			}
+		}
+
+		if (texPrefix) {
+			for (size_t i = 1; i <= texCount; i++)
+				res.emplace_back(std::format("font{}.tex", i), std::format("{}{}.tex", texPrefix, i));
+		}
+	};
+
+	if (m_multiFontSet.ExportMapFontLobbyToFont) {
+		for (const auto& pFace : fontSet.Faces)
+			res.emplace_back(std::format("{}.fdt", pFace->Name), std::format("{}_lobby.fdt", pFace->Name));
+		for (size_t i = 1; i <= texCount; i++)
+			res.emplace_back(std::format("font{}.tex", i), std::format("font_lobby{}.tex", i));
+	}
+
+	if (m_multiFontSet.ExportMapChnAxisToFont)
+		addAxisAliases("ChnAXIS_", "font_chn_");
+
+	if (m_multiFontSet.ExportMapKrnAxisToFont)
+		addAxisAliases("KrnAXIS_", "font_krn_");
+
+	// Traditional Chinese client reads its AXIS fonts from the same textures.
+	if (m_multiFontSet.ExportMapTCAxisToFont)
+		addAxisAliases("tcaxis_", nullptr);
+
+	return res;
+}
+
+void App::FontSetExporter::WriteStreamToFile(const xivres::stream& stream, const std::filesystem::path& path, std::span<char> buf) const {
+	const auto trace = TraceRecorder::Scope(m_trace.get(), "Write", "export", nlohmann::json::object({{"file", xivres::util::unicode::convert<std::string>(path.filename().wstring())}}));
+	std::filesystem::remove(path);
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+		throw std::runtime_error(std::format("Failed to create {}", xivres::util::unicode::convert<std::string>(path.wstring())));
+
+	for (size_t read, pos = 0; (read = stream.read(pos, buf.data(), buf.size())); pos += read) {
+		m_progress.ThrowIfCancelled();
+		out.write(buf.data(), read);
+	}
+
+	out.close();
+	if (!out)
+		throw std::runtime_error(std::format("Failed to write {}", xivres::util::unicode::convert<std::string>(path.wstring())));
+}
+
+void App::FontSetExporter::ClearZipTimestamps(const std::filesystem::path& path) {
+	// 1980-01-01 00:00:00 in MS-DOS date and time format.
+	static constexpr uint16_t DosTime = 0;
+	static constexpr uint16_t DosDate = (1 << 5) | 1;
+
+	static constexpr uint32_t LocalFileHeaderSignature = 0x04034b50;
+	static constexpr uint32_t CentralDirectoryHeaderSignature = 0x02014b50;
+	static constexpr uint32_t EndOfCentralDirectorySignature = 0x06054b50;
+	static constexpr uint32_t Zip64EndOfCentralDirectorySignature = 0x06064b50;
+	static constexpr uint32_t Zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+	static constexpr uint16_t Zip64ExtraFieldId = 0x0001;
+	static constexpr uint16_t NtfsExtraFieldId = 0x000A;
+	static constexpr uint16_t ExtendedTimestampExtraFieldId = 0x5455;
+
+	const auto error = [&path](const char* what) {
+		return std::runtime_error(std::format("{}: {}", xivres::util::unicode::convert<std::string>(path.wstring()), what));
+	};
+
+	std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+	if (!f)
+		throw error("Failed to open");
+
+	const auto read = [&](uint64_t offset, size_t length) {
+		std::vector<uint8_t> buf(length);
+		f.seekg(static_cast<std::streamoff>(offset));
+		if (!f.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(length)))
+			throw error("Failed to read");
+		return buf;
+	};
+	const auto write = [&](uint64_t offset, std::span<const uint8_t> data) {
+		f.seekp(static_cast<std::streamoff>(offset));
+		if (!f.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())))
+			throw error("Failed to write");
+	};
+	const auto get = [](const std::vector<uint8_t>& buf, size_t offset, auto value) {
+		if (offset + sizeof value > buf.size())
+			throw std::out_of_range("Truncated zip record");
+		std::memcpy(&value, &buf[offset], sizeof value);
+		return static_cast<uint64_t>(value);
+	};
+	const auto setTimestamp = [](uint8_t* p) {
+		std::memcpy(p, &DosTime, sizeof DosTime);
+		std::memcpy(p + sizeof DosTime, &DosDate, sizeof DosDate);
+	};
+
+	// Extra fields may carry timestamps of their own, at a finer precision than the MS-DOS one.
+	const auto clearExtraTimestamps = [&get](std::vector<uint8_t>& buf, size_t begin, size_t length) {
+		const auto end = begin + length;
+		for (auto extra = begin; extra + 4 <= end;) {
+			const auto id = get(buf, extra, uint16_t{});
+			const auto data = extra + 4;
+			const auto dataEnd = data + static_cast<size_t>(get(buf, extra + 2, uint16_t{}));
+			if (dataEnd > end)
+				throw std::out_of_range("Truncated zip extra field");
+
+			if (id == ExtendedTimestampExtraFieldId) {
+				// Flags, followed by 32-bit Unix times.
+				if (dataEnd > data + 1)
+					std::fill(&buf[data + 1], &buf[0] + dataEnd, uint8_t{});
+			} else if (id == NtfsExtraFieldId) {
+				// Reserved, followed by tagged attributes; tag 1 holds the times as 64-bit FILETIMEs.
+				for (auto attr = data + 4; attr + 4 <= dataEnd;) {
+					const auto attrEnd = attr + 4 + static_cast<size_t>(get(buf, attr + 2, uint16_t{}));
+					if (attrEnd > dataEnd)
+						throw std::out_of_range("Truncated NTFS extra field");
+					if (get(buf, attr, uint16_t{}) == 1)
+						std::fill(&buf[0] + attr + 4, &buf[0] + attrEnd, uint8_t{});
+					attr = attrEnd;
+				}
+			}
+
+			extra = dataEnd;
+		}
+	};
+
+	// The end of central directory record is the last thing in the file, followed by a comment of at most 65535 bytes.
+	f.seekg(0, std::ios::end);
+	const auto fileSize = static_cast<uint64_t>(f.tellg());
+	if (fileSize < 22)
+		throw error("Not a zip file");
+	const auto tailOffset = fileSize - (std::min<uint64_t>)(fileSize, 22 + 65535);
+	const auto tail = read(tailOffset, static_cast<size_t>(fileSize - tailOffset));
+
+	auto eocd = tail.size() - 22;
+	while (get(tail, eocd, uint32_t{}) != EndOfCentralDirectorySignature) {
+		if (eocd == 0)
+			throw error("Not a zip file");
+		eocd--;
+	}
+
+	auto entryCount = get(tail, eocd + 10, uint16_t{});
+	auto directorySize = get(tail, eocd + 12, uint32_t{});
+	auto directoryOffset = get(tail, eocd + 16, uint32_t{});
+	if (entryCount == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) {
+		if (eocd < 20 || get(tail, eocd - 20, uint32_t{}) != Zip64EndOfCentralDirectoryLocatorSignature)
+			throw error("Zip64 end of central directory locator not found");
+
+		const auto zip64Eocd = read(get(tail, eocd - 20 + 8, uint64_t{}), 56);
+		if (get(zip64Eocd, 0, uint32_t{}) != Zip64EndOfCentralDirectorySignature)
+			throw error("Zip64 end of central directory record not found");
+		entryCount = get(zip64Eocd, 32, uint64_t{});
+		directorySize = get(zip64Eocd, 40, uint64_t{});
+		directoryOffset = get(zip64Eocd, 48, uint64_t{});
+	}
+
+	auto directory = read(directoryOffset, static_cast<size_t>(directorySize));
+	for (size_t pos = 0, i = 0; i < entryCount; i++) {
+		if (get(directory, pos, uint32_t{}) != CentralDirectoryHeaderSignature)
+			throw error("Corrupt central directory");
+
+		const auto compressedSize = get(directory, pos + 20, uint32_t{});
+		const auto uncompressedSize = get(directory, pos + 24, uint32_t{});
+		const auto nameLength = get(directory, pos + 28, uint16_t{});
+		const auto extraLength = get(directory, pos + 30, uint16_t{});
+		const auto commentLength = get(directory, pos + 32, uint16_t{});
+		auto localHeaderOffset = get(directory, pos + 42, uint32_t{});
+		setTimestamp(&directory[pos + 12]);
+		clearExtraTimestamps(directory, static_cast<size_t>(pos + 46 + nameLength), static_cast<size_t>(extraLength));
+
+		// Zip64 extra field holds 64-bit values, in this order, for each of these that did not fit.
+		if (localHeaderOffset == 0xFFFFFFFF) {
+			const auto extraBegin = pos + 46 + nameLength;
+			for (auto extra = extraBegin; extra + 4 <= extraBegin + extraLength; extra += 4 + get(directory, extra + 2, uint16_t{})) {
+				if (get(directory, extra, uint16_t{}) != Zip64ExtraFieldId)
+					continue;
+
+				auto field = extra + 4;
+				if (uncompressedSize == 0xFFFFFFFF)
+					field += 8;
+				if (compressedSize == 0xFFFFFFFF)
+					field += 8;
+				localHeaderOffset = get(directory, field, uint64_t{});
+				break;
+			}
+		}
+
+		// Local file header may have different extra fields from the central directory.
+		const auto localHeaderBegin = read(localHeaderOffset, 30);
+		if (get(localHeaderBegin, 0, uint32_t{}) != LocalFileHeaderSignature)
+			throw error("Corrupt local file header");
+		const auto localNameLength = get(localHeaderBegin, 26, uint16_t{});
+		const auto localExtraLength = get(localHeaderBegin, 28, uint16_t{});
+		auto localHeader = read(localHeaderOffset, static_cast<size_t>(30 + localNameLength + localExtraLength));
+		setTimestamp(&localHeader[10]);
+		clearExtraTimestamps(localHeader, static_cast<size_t>(30 + localNameLength), static_cast<size_t>(localExtraLength));
+		write(localHeaderOffset, localHeader);
+
+		pos += 46 + nameLength + extraLength + commentLength;
+	}
+
+	write(directoryOffset, directory);
+}
+
+void App::FontSetExporter::CreateAlias(const std::filesystem::path& source, const std::filesystem::path& alias) {
+	std::filesystem::remove(alias);
+
+	if (CreateHardLinkW(alias.c_str(), source.c_str(), nullptr))
+		return;
+
+	// Hard links are unavailable on FAT volumes; try cloning the blocks instead, which ReFS supports.
+	if (const auto hSource = CreateFileW(source.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr); hSource != INVALID_HANDLE_VALUE) {
+		const auto closeSource = xivres::util::on_dtor([hSource]() { CloseHandle(hSource); });
+
+		LARGE_INTEGER size{};
+		std::wstring volumePath(MAX_PATH, L'\0');
+		DWORD sectorsPerCluster{}, bytesPerSector{}, freeClusters{}, totalClusters{};
+		if (GetFileSizeEx(hSource, &size)
+			&& GetVolumePathNameW(source.c_str(), &volumePath[0], static_cast<DWORD>(volumePath.size()))
+			&& GetDiskFreeSpaceW(volumePath.c_str(), &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters)) {
+
+			if (const auto hAlias = CreateFileW(alias.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_NEW, 0, nullptr); hAlias != INVALID_HANDLE_VALUE) {
+				auto bCloned = false;
+				{
+					const auto closeAlias = xivres::util::on_dtor([hAlias]() { CloseHandle(hAlias); });
+
+					// Cloned ranges have to be aligned to clusters; whatever lies past the end of the source is cut off by the file size.
+					const auto clusterSize = static_cast<LONGLONG>(sectorsPerCluster) * bytesPerSector;
+					DUPLICATE_EXTENTS_DATA dup{};
+					dup.FileHandle = hSource;
+					dup.ByteCount.QuadPart = (size.QuadPart + clusterSize - 1) / clusterSize * clusterSize;
+
+					FILE_END_OF_FILE_INFO eof{};
+					eof.EndOfFile = size;
+
+					DWORD returned{};
+					bCloned = SetFileInformationByHandle(hAlias, FileEndOfFileInfo, &eof, sizeof eof)
+						&& DeviceIoControl(hAlias, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &dup, sizeof dup, nullptr, 0, &returned, nullptr);
+				}
+
+				if (bCloned)
+					return;
+
+				std::filesystem::remove(alias);
+			}
+		}
+	}
+
+	copy_file(source, alias, std::filesystem::copy_options::overwrite_existing);
+}
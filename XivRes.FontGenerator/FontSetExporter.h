@@ -0,0 +1,154 @@
+#pragma once
+
+#include "FontDataCache.h"
+#include "Structs.h"
+#include "TraceRecorder.h"
+
+namespace App {
+	class ExportProgress {
+	public:
+		virtual ~ExportProgress() = default;
+
+		virtual void ThrowIfCancelled() const = 0;
+
+		virtual bool IsCancelled() const = 0;
+
+		virtual void UpdateStatusMessage(std::wstring_view s) = 0;
+
+		virtual void UpdateProgress(float progress) = 0;
+	};
+
+	class FontSetExporter {
+	public:
+		enum class CompressionMode : uint8_t {
+			CompressWhilePacking,
+			CompressAfterPacking,
+			DoNotCompress,
+		};
+
+		using CompiledFontSet = std::pair<std::vector<std::shared_ptr<xivres::fontdata::stream>>, std::vector<std::shared_ptr<xivres::texture::memory_mipmap_stream>>>;
+
+		struct Statistics {
+			// Glyph and kerning pair counts are only known for FontSets that did not come from the compiled cache.
+			size_t GlyphCount = 0;
+			size_t KerningPairCount = 0;
+			size_t TextureCount = 0;
+
+			// Number of textures the glyphs would take if every plane were filled up to the bottom; see GetUsedTextureCount.
+			double UsedTextureCount = 0;
+		};
+
+		struct LayoutTrial {
+			int SideLength = 0;
+			int DiscardStep = 0;
+
+			// Zero if the FontSet failed to compile with this layout; see Error.
+			size_t TextureCount = 0;
+			double UsedTextureCount = 0;
+			std::chrono::milliseconds Duration{};
+			std::wstring Error;
+
+			[[nodiscard]] uint64_t GetTextureBytes() const;
+		};
+
+		struct LayoutSearchResult {
+			size_t TextureCountLimit = 0;
+			std::vector<LayoutTrial> Trials;
+
+			// Index of the chosen trial, or empty if none of them fit within the limit.
+			std::optional<size_t> Chosen;
+
+			// Whether the chosen layout differs from what the FontSet had.
+			bool bChanged = false;
+		};
+
+	private:
+		using PackedEntry = std::pair<std::string, std::shared_ptr<xivres::packed_stream>>;
+
+		class PipelineAbortedError : public std::runtime_error {
+		public:
+			PipelineAbortedError() : std::runtime_error("Aborted") {}
+		};
+
+		Structs::MultiFontSet& m_multiFontSet;
+		ExportProgress& m_progress;
+		bool m_bExpectedTexCountChanged = false;
+		bool m_bStoreCompiledCache = true;
+		std::atomic_bool m_bAbortPipeline = false;
+		std::shared_ptr<FontDataCache> m_cache;
+		std::shared_ptr<TraceRecorder> m_trace;
+
+		mutable std::mutex m_statisticsMtx;
+		Statistics m_statistics;
+
+	public:
+		FontSetExporter(Structs::MultiFontSet& multiFontSet, ExportProgress& progress);
+
+		// Record the time taken by each step of compiling and exporting into the recorder, or stop recording if null.
+		void SetTraceRecorder(std::shared_ptr<TraceRecorder> trace);
+
+		CompiledFontSet Compile(Structs::FontSet& fontSet);
+
+		// Compile every FontSet in order and pass each result to the callback.
+		// The next FontSet gets compiled in background while the callback is running, unless it would exceed the memory budget.
+		void ForEachCompiledFontSet(const std::function<void(Structs::FontSet&, CompiledFontSet&&)>& cb);
+
+		// Compile the FontSet with each candidate side length and discard step in parallel, and keep the layout taking the least texture memory
+		// within the number of textures the game can load for the FontSet; ties go to the larger discard step, which packs faster.
+		// The first trial runs alone to learn the area taken by the glyphs, and further trials run only as many at once as the memory budget allows.
+		LayoutSearchResult OptimizeLayout(Structs::FontSet& fontSet);
+
+		// Get the number of textures the game can load for the FontSet, including the names it is additionally exported under.
+		[[nodiscard]] size_t GetTextureCountLimit(const Structs::FontSet& fontSet) const;
+
+		void ExportToTTMP(const std::filesystem::path& path, CompressionMode compressionMode);
+
+		void ExportToRaw(const std::filesystem::path& basePath);
+
+		// Whether any FontSet::ExpectedTexCount got updated from the compilation result.
+		[[nodiscard]] bool IsExpectedTexCountChanged() const;
+
+		// Get the totals over every FontSet compiled so far.
+		[[nodiscard]] Statistics GetStatistics() const;
+
+		// Get how much of the textures the packer has used, in number of textures.
+		// Glyphs are laid out from the top of each plane (color channel), so a plane counts as used up to its last row with any pixel in it.
+		// This only measures the packing; glyph placement itself is done by xivres::fontdata_packer, which is not part of this project.
+		static double GetUsedTextureCount(const std::vector<std::shared_ptr<xivres::texture::memory_mipmap_stream>>& mips);
+
+	private:
+		void UpdateExpectedTexCount(Structs::FontSet& fontSet, size_t texCount);
+
+		bool IsCancelled() const;
+
+		void ThrowIfCancelled() const;
+
+		CompiledFontSet Compile(Structs::FontSet& fontSet, ExportProgress& progress);
+
+		static uint64_t EstimateMemoryUsage(int sideLength, size_t texCount);
+
+		// Get the memory taken by a compiled FontSet held until it is written.
+		static uint64_t GetMemoryUsage(const CompiledFontSet& compiled);
+
+		// Compile a copy of the FontSet with the layout of the trial, and fill in the rest of the trial from the result.
+		void RunLayoutTrial(const Structs::FontSet& fontSet, LayoutTrial& trial) const;
+
+		// Create packed streams one by one and pass them to the writer in order, optionally compressing upcoming ones on worker threads.
+		// Only a few entries are alive at a time, and each is released as soon as it has been written.
+		// Pages come from a FontSet that has been compiled in full, so this shortens how long they stay in memory, not how many are made at once.
+		void WritePackedInOrder(size_t count, bool bCompressInParallel, const std::function<PackedEntry(size_t)>& createEntry, const std::function<void(const PackedEntry&)>& writeEntry);
+
+		// Get the files to be exported once more under different names for other game regions, as pairs of (file name, alias name).
+		std::vector<std::pair<std::string, std::string>> GetAliases(const Structs::FontSet& fontSet, size_t texCount) const;
+
+		// Write the stream into a newly created file, so that any hard link made by a previous export is left untouched.
+		void WriteStreamToFile(const xivres::stream& stream, const std::filesystem::path& path, std::span<char> buf) const;
+
+		// Make the file available under another name, by sharing its data with a hard link or a block clone if the file system allows.
+		static void CreateAlias(const std::filesystem::path& source, const std::filesystem::path& alias);
+
+		// Set the modification time of every entry in the zip file to the earliest one the format can store, in place.
+		// Times in extended timestamp (0x5455) and NTFS (0x000A) extra fields are zeroed in both the local and the central headers.
+		static void ClearZipTimestamps(const std::filesystem::path& path);
+	};
+}
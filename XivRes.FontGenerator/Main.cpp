@@ -1,8 +1,10 @@
 ﻿#include "pch.h"
 #include "resource.h"
 
+#include "CommandLineCompiler.h"
 #include "ExportPreviewWindow.h"
 #include "FaceElementEditorDialog.h"
+#include "FontFamilyCatalogue.h"
 #include "Structs.h"
 #include "MainWindow.h"
 #include "FontGeneratorConfig.h"
@@ -15,7 +17,15 @@ WORD g_langId;
 std::wstring g_localeName;
 FontGeneratorConfig g_config;
 
-int __stdcall WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
+// XivRes.FontGenerator.Cli.vcxproj builds this as a console program, which only runs the command line compiler.
+// Shells and CI runners wait for a console program and can redirect its output, unlike a GUI one attaching to their console.
+#ifdef XIVRES_FONTGENERATOR_CLI
+static constexpr bool IsConsoleProgram = true;
+#else
+static constexpr bool IsConsoleProgram = false;
+#endif
+
+static int Run(HINSTANCE hInstance) {
 	g_hInstance = hInstance;
 
 	SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
@@ -31,6 +41,10 @@ int __stdcall WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
 		}
 	}
 
+	const auto bHeadless = IsConsoleProgram || App::CommandLineCompiler::IsRequested(args);
+	if (bHeadless)
+		App::CommandLineCompiler::PrepareConsole(IsConsoleProgram);
+
 	if (wchar_t localeName[LOCALE_NAME_MAX_LENGTH];
 		GetUserDefaultLocaleName(localeName, LOCALE_NAME_MAX_LENGTH)) {
 		g_localeName = localeName;
@@ -67,6 +81,12 @@ int __stdcall WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
 		return 1;
 	}
 
+	if (bHeadless)
+		return App::CommandLineCompiler(std::move(args)).Run();
+
+	// Editor dialogs will need the list of fonts; get it ready before anyone asks.
+	App::FontFamilyCatalogue::BeginLoad();
+
 	App::FontEditorWindow window(std::move(args));
 	for (MSG msg{}; GetMessageW(&msg, nullptr, 0, 0);) {
 		if (App::BaseWindow::ConsumeMessage(msg))
@@ -78,3 +98,13 @@ int __stdcall WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nShowCmd) {
 
 	return 0;
 }
+
+#ifdef XIVRES_FONTGENERATOR_CLI
+int wmain() {
+	return Run(GetModuleHandleW(nullptr));
+}
+#else
+int __stdcall WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
+	return Run(hInstance);
+}
+#endif
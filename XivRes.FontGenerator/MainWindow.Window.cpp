@@ -55,6 +55,8 @@ LRESULT App::FontEditorWindow::Window_OnCreate(HWND hwnd) {
 	SystemParametersInfoW(SPI_GETNONCLIENTMETRICS, sizeof ncm, &ncm, 0);
 	m_hUiFont = CreateFontIndirectW(&ncm.lfMessageFont);
 
+	m_previewRenderer = std::make_unique<PreviewRenderer>(m_hWnd, WmPreviewRendered);
+
 	m_hFacesListBox = CreateWindowExW(0, WC_LISTBOXW, nullptr,
 		WS_CHILD | WS_TABSTOP | WS_BORDER | WS_VISIBLE | LBS_NOINTEGRALHEIGHT | LBS_NOTIFY,
 		0, 0, 0, 0, m_hWnd, reinterpret_cast<HMENU>(Id_FaceListBox), reinterpret_cast<HINSTANCE>(GetWindowLongPtrW(m_hWnd, GWLP_HINSTANCE)), nullptr);
@@ -178,71 +180,53 @@ LRESULT App::FontEditorWindow::Window_OnPaint() {
 		BITMAPINFO bmi{};
 	};
 
-	PAINTSTRUCT ps;
-	const auto hdc = BeginPaint(m_hWnd, &ps);
+	RECT rc;
+	GetClientRect(m_hWnd, &rc);
+
 	if (m_bNeedRedraw) {
 		m_bNeedRedraw = false;
 
-		RECT rc;
-		GetClientRect(m_hWnd, &rc);
-		m_pMipmap = std::make_shared<xivres::texture::memory_mipmap_stream>(
-			(std::max<int>)(1, (rc.right - rc.left - m_nDrawLeft + m_nZoom - 1) / m_nZoom),
-			(std::max<int>)(1, (rc.bottom - rc.top - m_nDrawTop + m_nZoom - 1) / m_nZoom),
-			1,
-			xivres::texture::formats::B8G8R8A8);
-
-		const auto pad = 16 / m_nZoom;
-		const auto buf = m_pMipmap->as_span<xivres::util::b8g8r8a8>();
-		std::ranges::fill(buf, xivres::util::b8g8r8a8{ 0x88, 0x88, 0x88, 0xFF });
-
-		for (int y = pad; y < m_pMipmap->Height - pad; y++) {
-			for (int x = pad; x < m_pMipmap->Width - pad; x++)
-				buf[y * m_pMipmap->Width + x] = { 0x00, 0x00, 0x00, 0xFF };
-		}
-
-		if (m_pActiveFace) {
-			auto& face = *m_pActiveFace;
-
-			const auto& mergedFont = *face.GetMergedFont();
+		// The face is copied, as it may change before the worker gets to it.
+		m_previewRenderer->Submit({
+			.Face = m_pActiveFace ? std::make_shared<Structs::Face>(*m_pActiveFace) : nullptr,
+			.SourceFace = m_pActiveFace,
+			.Width = (std::max<int>)(1, (rc.right - rc.left - m_nDrawLeft + m_nZoom - 1) / m_nZoom),
+			.Height = (std::max<int>)(1, (rc.bottom - rc.top - m_nDrawTop + m_nZoom - 1) / m_nZoom),
+			.Padding = 16 / m_nZoom,
+			.WordWrap = m_bWordWrap,
+			.Kerning = m_bKerning,
+			.ShowLineMetrics = m_bShowLineMetrics,
+		});
+	}
 
-			if (int lineHeight = mergedFont.line_height(), ascent = mergedFont.ascent(); lineHeight > 0 && m_bShowLineMetrics) {
-				if (ascent < lineHeight) {
-					for (int y = pad, y_ = m_pMipmap->Height - pad; y < y_; y += lineHeight) {
-						for (int y2 = y + ascent, y2_ = (std::min)(y_, y + lineHeight); y2 < y2_; y2++)
-							for (int x = pad; x < m_pMipmap->Width - pad; x++)
-								buf[y2 * m_pMipmap->Width + x] = { 0x33, 0x33, 0x33, 0xFF };
-					}
-				} else if (ascent == lineHeight) {
-					for (int y = pad, y_ = m_pMipmap->Height - pad; y < y_; y += 2 * lineHeight) {
-						for (int y2 = y + lineHeight, y2_ = (std::min)(y_, y + 2 * lineHeight); y2 < y2_; y2++)
-							for (int x = pad; x < m_pMipmap->Width - pad; x++)
-								buf[y2 * m_pMipmap->Width + x] = { 0x33, 0x33, 0x33, 0xFF };
-					}
-				}
-			}
+	PAINTSTRUCT ps;
+	const auto hdc = BeginPaint(m_hWnd, &ps);
 
-			if (!face.PreviewText.empty()) {
-				xivres::fontgen::text_measurer(mergedFont)
-					.max_width(m_bWordWrap ? m_pMipmap->Width - pad * 2 : (std::numeric_limits<int>::max)())
-					.use_kerning(m_bKerning)
-					.measure(face.PreviewText)
-					.draw_to(*m_pMipmap, mergedFont, pad, pad, { 0xFF, 0xFF, 0xFF, 0xFF }, { 0, 0, 0, 0 });
-			}
-		}
+	// Until the frame for the current size is ready, show the previous one and fill the rest with the border color.
+	auto drawnRight = m_nDrawLeft;
+	auto drawnBottom = m_nDrawTop;
+	if (const auto frame = m_previewRenderer->GetLatestFrame()) {
+		const auto& mipmap = *frame->Mipmap;
+		bmi.bmiHeader.biSize = sizeof bmi.bmiHeader;
+		bmi.bmiHeader.biWidth = mipmap.Width;
+		bmi.bmiHeader.biHeight = -mipmap.Height;
+		bmi.bmiHeader.biPlanes = 1;
+		bmi.bmiHeader.biBitCount = 32;
+		bmi.bmiHeader.biCompression = BI_BITFIELDS;
+		reinterpret_cast<xivres::util::b8g8r8a8*>(&bmi.bmiColors[0])->set_components(255, 0, 0, 0);
+		reinterpret_cast<xivres::util::b8g8r8a8*>(&bmi.bmiColors[1])->set_components(0, 255, 0, 0);
+		reinterpret_cast<xivres::util::b8g8r8a8*>(&bmi.bmiColors[2])->set_components(0, 0, 255, 0);
+		StretchDIBits(hdc, m_nDrawLeft, m_nDrawTop, mipmap.Width * m_nZoom, mipmap.Height * m_nZoom, 0, 0, mipmap.Width, mipmap.Height, mipmap.as_span<xivres::util::b8g8r8a8>().data(), &bmi, DIB_RGB_COLORS, SRCCOPY);
+		drawnRight += mipmap.Width * m_nZoom;
+		drawnBottom += mipmap.Height * m_nZoom;
 	}
 
-	bmi.bmiHeader.biSize = sizeof bmi.bmiHeader;
-	bmi.bmiHeader.biWidth = m_pMipmap->Width;
-	bmi.bmiHeader.biHeight = -m_pMipmap->Height;
-	bmi.bmiHeader.biPlanes = 1;
-	bmi.bmiHeader.biBitCount = 32;
-	bmi.bmiHeader.biCompression = BI_BITFIELDS;
-	reinterpret_cast<xivres::util::b8g8r8a8*>(&bmi.bmiColors[0])->set_components(255, 0, 0, 0);
-	reinterpret_cast<xivres::util::b8g8r8a8*>(&bmi.bmiColors[1])->set_components(0, 255, 0, 0);
-	reinterpret_cast<xivres::util::b8g8r8a8*>(&bmi.bmiColors[2])->set_components(0, 0, 255, 0);
-	RECT rc;
-	GetClientRect(m_hWnd, &rc);
-	StretchDIBits(hdc, m_nDrawLeft, m_nDrawTop, m_pMipmap->Width * m_nZoom, m_pMipmap->Height * m_nZoom, 0, 0, m_pMipmap->Width, m_pMipmap->Height, m_pMipmap->as_span<xivres::util::b8g8r8a8>().data(), &bmi, DIB_RGB_COLORS, SRCCOPY);
+	SetDCBrushColor(hdc, RGB(0x88, 0x88, 0x88));
+	if (const RECT rcRight{ drawnRight, m_nDrawTop, rc.right, rc.bottom }; rcRight.left < rcRight.right && rcRight.top < rcRight.bottom)
+		FillRect(hdc, &rcRight, GetStockBrush(DC_BRUSH));
+	if (const RECT rcBottom{ m_nDrawLeft, drawnBottom, (std::min)(drawnRight, rc.right), rc.bottom }; rcBottom.left < rcBottom.right && rcBottom.top < rcBottom.bottom)
+		FillRect(hdc, &rcBottom, GetStockBrush(DC_BRUSH));
+
 	EndPaint(m_hWnd, &ps);
 
 	return 0;
@@ -307,11 +291,25 @@ LRESULT App::FontEditorWindow::Window_OnMouseLButtonUp(uint16_t states, int16_t
 }
 
 LRESULT App::FontEditorWindow::Window_OnDestroy() {
+	m_previewRenderer = nullptr;
 	DeleteFont(m_hUiFont);
 	PostQuitMessage(0);
 	return 0;
 }
 
+LRESULT App::FontEditorWindow::Window_OnPreviewRendered() {
+	// While exporting, the fonts of the face being edited may be in use by the exporter; the preview is drawn again afterwards.
+	if (!m_previewRenderer || m_previewRenderer->IsPaused())
+		return 0;
+
+	// Keep the fonts the worker has created, so that they do not get created again for the next frame.
+	if (const auto frame = m_previewRenderer->GetLatestFrame(); frame && frame->Face && m_pActiveFace && frame->SourceFace == m_pActiveFace)
+		m_pActiveFace->AdoptFontsFrom(*frame->Face);
+
+	InvalidateRect(m_hWnd, nullptr, FALSE);
+	return 0;
+}
+
 void App::FontEditorWindow::Window_Redraw() {
 	if (!m_pActiveFace)
 		return;
@@ -376,6 +374,7 @@ LRESULT App::FontEditorWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
 				case ID_VIEW_800: return Menu_View_Zoom(8);
 				case ID_VIEW_900: return Menu_View_Zoom(9);
 				case ID_EXPORT_PREVIEW: return Menu_Export_Preview();
+				case ID_EXPORT_OPTIMIZELAYOUT: return Menu_Export_OptimizeLayout();
 				case ID_EXPORT_RAW: return Menu_Export_Raw();
 				case ID_EXPORT_TOTTMP_COMPRESSWHILEPACKING: return Menu_Export_TTMP(CompressionMode::CompressWhilePacking);
 				case ID_EXPORT_TOTTMP_COMPRESSAFTERPACKING: return Menu_Export_TTMP(CompressionMode::CompressAfterPacking);
@@ -406,6 +405,7 @@ LRESULT App::FontEditorWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
 		case WM_INITMENUPOPUP: return Window_OnInitMenuPopup(reinterpret_cast<HMENU>(wParam), LOWORD(lParam), !!HIWORD(lParam));
 		case WM_CLOSE: return Menu_File_Exit();
 		case WM_DESTROY: return Window_OnDestroy();
+		case WmPreviewRendered: return Window_OnPreviewRendered();
 	}
 
 	return DefWindowProcW(hwnd, msg, wParam, lParam);
@@ -268,81 +268,3 @@ void App::FontEditorWindow::UpdateFaceElementListViewItem(const Structs::FaceEle
 	setItemText(ListViewColsRenderer, element.GetRendererRepresentation());
 	setItemText(ListViewColsLookup, element.GetLookupRepresentation());
 }
-
-std::pair<std::vector<std::shared_ptr<xivres::fontdata::stream>>, std::vector<std::shared_ptr<xivres::texture::memory_mipmap_stream>>> App::FontEditorWindow::CompileCurrentFontSet(ProgressDialog& progressDialog, Structs::FontSet& fontSet) {
-	progressDialog.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_LOADFONTS));
-	fontSet.ConsolidateFonts();
-
-	{
-		progressDialog.UpdateStatusMessage(GetStringResource(IDS_EXPORTPROGRESS_KERNINGPAIRS));
-		xivres::util::thread_pool::pool pool(1);
-		xivres::util::thread_pool::task_waiter<std::pair<Structs::Face*, size_t>> waiter(pool);
-		for (auto& pFace : fontSet.Faces) {
-			waiter.submit([pFace = pFace.get(), &progressDialog](auto&) -> std::pair<Structs::Face*, size_t> {
-				if (progressDialog.IsCancelled())
-					return {pFace, 0};
-				return {pFace, pFace->GetMergedFont()->all_kerning_pairs().size()};
-			});
-		}
-
-		std::vector<std::string> tooManyKernings;
-		for (std::optional<std::pair<Structs::Face*, size_t>> res; (res = waiter.get());) {
-			const auto& [pFace, nKerns] = *res;
-			if (nKerns >= 65536)
-				tooManyKernings.emplace_back(std::format("\n{}: {}", pFace->Name, nKerns));
-		}
-		if (!tooManyKernings.empty()) {
-			std::ranges::sort(tooManyKernings);
-			std::wstring s(GetStringResource(IDS_ERROR_KERNINGTABLETOOLARGE));
-			for (const auto& s2 : tooManyKernings)
-				s += xivres::util::unicode::convert<std::wstring>(s2);
-			throw WException(s);
-		}
-	}
-	progressDialog.ThrowIfCancelled();
-
-	xivres::fontgen::fontdata_packer packer;
-	packer.set_discard_step(fontSet.DiscardStep);
-	packer.set_side_length(fontSet.SideLength);
-
-	for (auto& pFace : fontSet.Faces)
-		packer.add_font(pFace->GetMergedFont());
-
-	packer.compile();
-
-	while (!packer.wait(std::chrono::milliseconds(200))) {
-		progressDialog.ThrowIfCancelled();
-
-		switch (packer.progress_description()) {
-			case xivres::fontgen::fontdata_packer::progress_status_t::prepare_source_fonts:
-				progressDialog.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_PREPARESOURCEFONTS));
-				break;
-			case xivres::fontgen::fontdata_packer::progress_status_t::prepare_target_fonts:
-				progressDialog.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_PREPARETARGETFONTS));
-				break;
-			case xivres::fontgen::fontdata_packer::progress_status_t::discover_glyphs:
-				progressDialog.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_DISCOVERGLYPHS));
-				break;
-			case xivres::fontgen::fontdata_packer::progress_status_t::measure_glyphs:
-				progressDialog.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_MEASUREGLYPHS));
-				break;
-			case xivres::fontgen::fontdata_packer::progress_status_t::layout_and_draw:
-				progressDialog.UpdateStatusMessage(GetStringResource(IDS_COMPILESTATUS_LAYOUTANDDRAW));
-				break;
-		}
-		progressDialog.UpdateProgress(packer.progress_scaled());
-	}
-	if (const auto err = packer.get_error_if_failed(); !err.empty())
-		throw std::runtime_error(err);
-
-	const auto& fdts = packer.compiled_fontdatas();
-	const auto& mips = packer.compiled_mipmap_streams();
-	if (mips.empty())
-		throw std::runtime_error("未生成任何多级纹理");
-
-	if (fontSet.ExpectedTexCount != static_cast<int>(mips.size())) {
-		fontSet.ExpectedTexCount = static_cast<int>(mips.size());
-		Changes_MarkDirty();
-	}
-	return std::make_pair(fdts, mips);
-}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "BaseWindow.h"
+#include "FontSetExporter.h"
+#include "PreviewRenderer.h"
 #include "Structs.h"
 
 namespace App {
@@ -9,6 +11,7 @@ namespace App {
 
 	class FontEditorWindow : public BaseWindow {
 		static constexpr auto ClassName = L"FontEditorWindowClass";
+		static constexpr UINT WmPreviewRendered = WM_APP + 1;
 
 		enum : uint8_t {
 			Id_None,
@@ -18,11 +21,7 @@ namespace App {
 			Id_Last_,
 		};
 
-		enum class CompressionMode : uint8_t {
-			CompressWhilePacking,
-			CompressAfterPacking,
-			DoNotCompress,
-		};
+		using CompressionMode = FontSetExporter::CompressionMode;
 
 		const std::vector<std::wstring> m_args;
 
@@ -33,7 +32,7 @@ namespace App {
 		Structs::FontSet* m_pFontSet = nullptr;
 		Structs::Face* m_pActiveFace = nullptr;
 
-		std::shared_ptr<xivres::texture::memory_mipmap_stream> m_pMipmap;
+		std::unique_ptr<PreviewRenderer> m_previewRenderer;
 		std::map<Structs::FaceElement*, std::unique_ptr<FaceElementEditorDialog>> m_editors;
 		bool m_bNeedRedraw = false;
 		bool m_bWordWrap = false;
@@ -75,6 +74,7 @@ namespace App {
 		LRESULT Window_OnMouseMove(uint16_t states, int16_t x, int16_t y);
 		LRESULT Window_OnMouseLButtonUp(uint16_t states, int16_t x, int16_t y);
 		LRESULT Window_OnDestroy();
+		LRESULT Window_OnPreviewRendered();
 		void Window_Redraw();
 
 		LRESULT Menu_File_New(xivres::font_type fontType);
@@ -103,6 +103,7 @@ namespace App {
 		LRESULT Menu_View_Zoom(int zoom);
 
 		LRESULT Menu_Export_Preview();
+		LRESULT Menu_Export_OptimizeLayout();
 		LRESULT Menu_Export_Raw();
 		LRESULT Menu_Export_TTMP(CompressionMode compressionMode);
 		LRESULT Menu_Export_MapFontLobby();
@@ -136,8 +137,6 @@ namespace App {
 		void UpdateFaceElementList();
 		void UpdateFaceElementListViewItem(const Structs::FaceElement& element);
 
-		std::pair<std::vector<std::shared_ptr<xivres::fontdata::stream>>, std::vector<std::shared_ptr<xivres::texture::memory_mipmap_stream>>> CompileCurrentFontSet(ProgressDialog&, Structs::FontSet& fontSet);
-
 		LRESULT WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 		static LRESULT WINAPI WndProcStatic(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
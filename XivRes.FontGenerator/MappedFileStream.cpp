@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "MappedFileStream.h"
+
+App::MappedFileStream::MappedFileStream(const std::filesystem::path& path) {
+	// Allow the font to be uninstalled while it is mapped; the mapping stays valid until closed.
+	m_hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		throw std::system_error(std::error_code(GetLastError(), std::system_category()));
+
+	try {
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(m_hFile, &fileSize))
+			throw std::system_error(std::error_code(GetLastError(), std::system_category()));
+		m_size = static_cast<size_t>(fileSize.QuadPart);
+
+		// Empty files cannot be mapped.
+		if (m_size) {
+			m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!m_hMapping)
+				throw std::system_error(std::error_code(GetLastError(), std::system_category()));
+
+			m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+			if (!m_pData)
+				throw std::system_error(std::error_code(GetLastError(), std::system_category()));
+		}
+	} catch (...) {
+		if (m_hMapping)
+			CloseHandle(m_hMapping);
+		CloseHandle(m_hFile);
+		throw;
+	}
+}
+
+App::MappedFileStream::~MappedFileStream() {
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	CloseHandle(m_hFile);
+}
+
+std::shared_ptr<App::MappedFileStream> App::MappedFileStream::Open(const std::filesystem::path& path) {
+	static std::mutex s_mtx;
+	static std::map<std::filesystem::path, std::weak_ptr<MappedFileStream>> s_streams;
+
+	const auto lock = std::lock_guard(s_mtx);
+	if (const auto it = s_streams.find(path); it != s_streams.end()) {
+		if (auto pStream = it->second.lock())
+			return pStream;
+	}
+
+	std::erase_if(s_streams, [](const auto& pair) { return pair.second.expired(); });
+
+	auto pStream = std::make_shared<MappedFileStream>(path);
+	s_streams[path] = pStream;
+	return pStream;
+}
+
+std::streamsize App::MappedFileStream::size() const {
+	return static_cast<std::streamsize>(m_size);
+}
+
+std::streamsize App::MappedFileStream::read(std::streamoff offset, void* buf, std::streamsize length) const {
+	if (offset < 0 || length <= 0 || static_cast<size_t>(offset) >= m_size)
+		return 0;
+
+	const auto available = (std::min)(static_cast<size_t>(length), m_size - static_cast<size_t>(offset));
+	memcpy(buf, m_pData + offset, available);
+	return static_cast<std::streamsize>(available);
+}
+
+std::span<const uint8_t> App::MappedFileStream::as_span() const {
+	return {m_pData, m_size};
+}
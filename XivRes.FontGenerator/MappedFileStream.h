@@ -0,0 +1,26 @@
+#pragma once
+
+namespace App {
+	// Read-only stream over a file mapped into memory as a whole.
+	class MappedFileStream : public xivres::stream {
+		HANDLE m_hFile = INVALID_HANDLE_VALUE;
+		HANDLE m_hMapping = nullptr;
+		const uint8_t* m_pData = nullptr;
+		size_t m_size = 0;
+
+	public:
+		MappedFileStream(const std::filesystem::path& path);
+		MappedFileStream(const MappedFileStream&) = delete;
+		MappedFileStream& operator=(const MappedFileStream&) = delete;
+		~MappedFileStream() override;
+
+		// Get the mapping of the file shared within the process; the file is mapped again only after every user of the previous mapping is gone.
+		static std::shared_ptr<MappedFileStream> Open(const std::filesystem::path& path);
+
+		[[nodiscard]] std::streamsize size() const override;
+
+		std::streamsize read(std::streamoff offset, void* buf, std::streamsize length) const override;
+
+		[[nodiscard]] std::span<const uint8_t> as_span() const;
+	};
+}
@@ -75,19 +75,34 @@ static std::wstring OemCpToWString(std::string_view sv) {
 	return buf;
 }
 
-void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const WException& e) {
+static bool s_bHeadless = false;
+
+void SetHeadlessErrorReporting(bool headless) {
+	s_bHeadless = headless;
+}
+
+static void ShowErrorMessageBoxImpl(HWND hParent, UINT preambleStringResID, std::wstring_view errorText) {
+	const auto message = std::format(L"{}\n\n{}", GetStringResource(preambleStringResID), errorText);
+	if (s_bHeadless) {
+		std::fputs(xivres::util::unicode::convert<std::string>(message).c_str(), stderr);
+		std::fputc('\n', stderr);
+		std::fflush(stderr);
+		return;
+	}
+
 	MessageBoxW(
 		hParent,
-		std::format(
-			L"{}\n\n{}",
-			GetStringResource(preambleStringResID),
-			e.what()).c_str(),
+		message.c_str(),
 		hParent
 		? GetWindowString(hParent).c_str()
 		: std::wstring(GetStringResource(IDS_APP)).c_str(),
 		MB_OK | MB_ICONERROR);
 }
 
+void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const WException& e) {
+	ShowErrorMessageBoxImpl(hParent, preambleStringResID, e.what());
+}
+
 void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const std::system_error& e) {
 	std::wstring errorText;
 	if (e.code().category() != std::system_category()) {
@@ -107,29 +122,11 @@ void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const std::syst
 			LocalFree(pErrorText);
 		}
 	}
-	MessageBoxW(
-		hParent,
-		std::format(
-			L"{}\n\n{}",
-			GetStringResource(preambleStringResID),
-			errorText.empty() ? OemCpToWString(e.what()) : errorText).c_str(),
-		hParent
-		? GetWindowString(hParent).c_str()
-		: std::wstring(GetStringResource(IDS_APP)).c_str(),
-		MB_OK | MB_ICONERROR);
+	ShowErrorMessageBoxImpl(hParent, preambleStringResID, errorText.empty() ? OemCpToWString(e.what()) : errorText);
 }
 
 void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const std::exception& e) {
-	MessageBoxW(
-		hParent,
-		std::format(
-			L"{}\n\n{}",
-			GetStringResource(preambleStringResID),
-			OemCpToWString(e.what())).c_str(),
-		hParent
-		? GetWindowString(hParent).c_str()
-		: std::wstring(GetStringResource(IDS_APP)).c_str(),
-		MB_OK | MB_ICONERROR);
+	ShowErrorMessageBoxImpl(hParent, preambleStringResID, OemCpToWString(e.what()));
 }
 
 std::wstring GetOpenTypeFeatureName(DWRITE_FONT_FEATURE_TAG tag) {
@@ -7,5 +7,6 @@ std::wstring_view GetStringResource(UINT id);
 void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const class WException& e);
 void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const class std::system_error& e);
 void ShowErrorMessageBox(HWND hParent, UINT preambleStringResID, const class std::exception& e);
+void SetHeadlessErrorReporting(bool headless);
 
 std::wstring GetOpenTypeFeatureName(enum DWRITE_FONT_FEATURE_TAG tag);
@@ -0,0 +1,322 @@
+#include "pch.h"
+#include "PreviewRenderer.h"
+
+App::PreviewRenderer::PreviewRenderer(HWND hNotifyWnd, UINT nNotifyMessage)
+	: m_hNotifyWnd(hNotifyWnd)
+	, m_nNotifyMessage(nNotifyMessage)
+	, m_thread([this]() { Worker(); }) {}
+
+App::PreviewRenderer::~PreviewRenderer() {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		m_bQuit = true;
+	}
+	m_cv.notify_all();
+	m_thread.join();
+}
+
+void App::PreviewRenderer::Submit(Request request) {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		m_pendingRequest.emplace(std::move(request));
+		m_nLatestRequestId++;
+	}
+	m_cv.notify_all();
+}
+
+std::shared_ptr<const App::PreviewRenderer::Frame> App::PreviewRenderer::GetLatestFrame() const {
+	const auto lock = std::lock_guard(m_mtx);
+	return m_latestFrame;
+}
+
+void App::PreviewRenderer::Pause() {
+	auto lock = std::unique_lock(m_mtx);
+	m_bPaused = true;
+	m_cv.wait(lock, [this]() { return !m_bRendering; });
+}
+
+void App::PreviewRenderer::Resume() {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		m_bPaused = false;
+	}
+	m_cv.notify_all();
+}
+
+bool App::PreviewRenderer::IsPaused() const {
+	const auto lock = std::lock_guard(m_mtx);
+	return m_bPaused;
+}
+
+void App::PreviewRenderer::Worker() {
+	SetThreadDescription(GetCurrentThread(), L"PreviewRenderer");
+
+	while (true) {
+		Request request;
+		uint64_t requestId;
+		{
+			auto lock = std::unique_lock(m_mtx);
+			m_cv.wait(lock, [this]() { return m_bQuit || (!m_bPaused && m_pendingRequest); });
+			if (m_bQuit)
+				return;
+
+			request = std::move(*m_pendingRequest);
+			m_pendingRequest.reset();
+			requestId = m_nLatestRequestId;
+			m_bRendering = true;
+		}
+
+		std::shared_ptr<Frame> frame;
+		try {
+			frame = Render(request, requestId);
+		} catch (const std::exception&) {
+			// Keep showing the previous frame.
+		}
+
+		// Drop the copy of the face here, as Pause waits only until this point.
+		request = {};
+
+		const auto bRendered = !!frame;
+		{
+			const auto lock = std::lock_guard(m_mtx);
+			m_bRendering = false;
+			if (bRendered)
+				m_latestFrame = std::move(frame);
+		}
+		m_cv.notify_all();
+		if (bRendered)
+			PostMessageW(m_hNotifyWnd, m_nNotifyMessage, 0, 0);
+	}
+}
+
+bool App::PreviewRenderer::IsSuperseded(uint64_t requestId) const {
+	const auto lock = std::lock_guard(m_mtx);
+	return m_bQuit || m_bPaused || m_nLatestRequestId != requestId;
+}
+
+std::shared_ptr<App::PreviewRenderer::Surface> App::PreviewRenderer::AcquireSurface(int width, int height) {
+	const auto lock = std::lock_guard(m_mtx);
+
+	// A surface whose mipmap is referenced from anywhere else is either the latest frame or being painted.
+	auto it = std::ranges::find_if(m_surfaces, [](const auto& pSurface) { return pSurface->Mipmap.use_count() == 1; });
+	if (it == m_surfaces.end()) {
+		m_surfaces.emplace_back(std::make_shared<Surface>());
+		it = m_surfaces.end() - 1;
+	}
+
+	auto& surface = **it;
+	if (!surface.Mipmap || surface.Mipmap->Width != width || surface.Mipmap->Height != height) {
+		surface.Mipmap = std::make_shared<xivres::texture::memory_mipmap_stream>(width, height, 1, xivres::texture::formats::B8G8R8A8);
+		surface.bValid = false;
+	}
+	return *it;
+}
+
+App::PreviewRenderer::MeasuredText& App::PreviewRenderer::Measure(const std::shared_ptr<xivres::fontgen::fixed_size_font>& pFont, const std::string& text, int maxWidth, bool kerning) {
+	LayoutKey key{
+		.Font = pFont.get(),
+		.Text = text,
+		.MaxWidth = maxWidth,
+		.Kerning = kerning,
+	};
+
+	auto it = m_layouts.find(key);
+	if (it == m_layouts.end()) {
+		it = m_layouts.emplace(std::move(key), LayoutEntry{
+			.Font = pFont,
+			.Measured = xivres::fontgen::text_measurer(*pFont)
+				.max_width(maxWidth)
+				.use_kerning(kerning)
+				.measure(text),
+		}).first;
+	}
+
+	it->second.LastUsedFrame = m_nFrameCounter;
+	return it->second.Measured;
+}
+
+void App::PreviewRenderer::Touch(const std::shared_ptr<xivres::fontgen::fixed_size_font>& pFont, const std::string& text, int maxWidth, bool kerning) {
+	if (const auto it = m_layouts.find(LayoutKey{.Font = pFont.get(), .Text = text, .MaxWidth = maxWidth, .Kerning = kerning}); it != m_layouts.end())
+		it->second.LastUsedFrame = m_nFrameCounter;
+}
+
+void App::PreviewRenderer::TrimLayouts() {
+	std::map<const xivres::fontgen::fixed_size_font*, uint64_t> fontLastUsedFrames;
+	for (const auto& [key, entry] : m_layouts) {
+		auto& lastUsedFrame = fontLastUsedFrames[key.Font];
+		lastUsedFrame = (std::max)(lastUsedFrame, entry.LastUsedFrame);
+	}
+
+	if (fontLastUsedFrames.size() > MaxLayoutCacheFonts) {
+		std::vector<uint64_t> frames;
+		for (const auto frame : fontLastUsedFrames | std::views::values)
+			frames.emplace_back(frame);
+		std::ranges::sort(frames, std::ranges::greater());
+
+		const auto oldestKeptFrame = frames[MaxLayoutCacheFonts - 1];
+		std::erase_if(m_layouts, [&](const auto& pair) { return fontLastUsedFrames.at(pair.first.Font) < oldestKeptFrame; });
+	}
+
+	if (m_layouts.size() > MaxLayoutCacheEntries)
+		std::erase_if(m_layouts, [this](const auto& pair) { return pair.second.LastUsedFrame != m_nFrameCounter; });
+}
+
+void App::PreviewRenderer::FillRows(Surface& surface, int y1, int y2) {
+	using pixel = xivres::util::b8g8r8a8;
+	constexpr pixel BorderColor{ 0x88, 0x88, 0x88, 0xFF };
+	constexpr pixel BackgroundColor{ 0x00, 0x00, 0x00, 0xFF };
+	constexpr pixel LineMetricsColor{ 0x33, 0x33, 0x33, 0xFF };
+
+	auto& mipmap = *surface.Mipmap;
+	const auto width = static_cast<size_t>(mipmap.Width);
+	const auto pad = surface.Padding;
+	const auto buf = mipmap.as_span<pixel>();
+
+	y1 = (std::max)(0, y1);
+	y2 = (std::min)(static_cast<int>(mipmap.Height), y2);
+	if (y1 >= y2)
+		return;
+
+	// Build one row of each kind, and copy them over; filling whole rows at once lets the copies vectorize.
+	const auto innerLeft = (std::min)(width, static_cast<size_t>(pad));
+	const auto innerRight = (std::max)(innerLeft, width - innerLeft);
+	std::vector<pixel> borderRow(width, BorderColor);
+	std::vector<pixel> backgroundRow(width, BorderColor);
+	std::vector<pixel> lineMetricsRow(width, BorderColor);
+	std::fill(backgroundRow.begin() + innerLeft, backgroundRow.begin() + innerRight, BackgroundColor);
+	std::fill(lineMetricsRow.begin() + innerLeft, lineMetricsRow.begin() + innerRight, LineMetricsColor);
+
+	const auto lineHeight = surface.LineHeight;
+	const auto ascent = surface.Ascent;
+	for (auto y = y1; y < y2; y++) {
+		const std::vector<pixel>* pRow;
+		if (y < pad || y >= mipmap.Height - pad)
+			pRow = &borderRow;
+		else if (!surface.bShowLineMetrics || lineHeight <= 0)
+			pRow = &backgroundRow;
+		else if (ascent < lineHeight)
+			pRow = (y - pad) % lineHeight >= ascent ? &lineMetricsRow : &backgroundRow;
+		else if (ascent == lineHeight)
+			pRow = (y - pad) % (2 * lineHeight) >= lineHeight ? &lineMetricsRow : &backgroundRow;
+		else
+			pRow = &backgroundRow;
+
+		std::copy_n(pRow->data(), width, &buf[y * width]);
+	}
+}
+
+std::shared_ptr<App::PreviewRenderer::Frame> App::PreviewRenderer::Render(const Request& request, uint64_t requestId) {
+	std::shared_ptr<xivres::fontgen::fixed_size_font> pFont;
+	if (request.Face) {
+		pFont = request.Face->GetMergedFont();
+		if (IsSuperseded(requestId))
+			return nullptr;
+	}
+
+	const auto pSurface = AcquireSurface(request.Width, request.Height);
+	auto& surface = *pSurface;
+	auto& mipmap = *surface.Mipmap;
+	const auto pad = request.Padding;
+	const auto lineHeight = pFont ? pFont->line_height() : 0;
+	const auto ascent = pFont ? pFont->ascent() : 0;
+
+	auto frame = std::make_shared<Frame>();
+	frame->Mipmap = surface.Mipmap;
+	frame->Face = request.Face;
+	frame->SourceFace = request.SourceFace;
+
+	// Lines get drawn separately unless word wrapping is on, so that only the changed ones need to be drawn again.
+	std::vector<std::string> lines;
+	if (pFont && !request.WordWrap && lineHeight > 0) {
+		for (const auto line : std::views::split(request.Face->PreviewText, '\n')) {
+			auto& l = lines.emplace_back(line.begin(), line.end());
+			if (!l.empty() && l.back() == '\r')
+				l.pop_back();
+		}
+	}
+
+	const auto bIncremental = surface.bValid
+		&& !lines.empty()
+		&& !surface.Lines.empty()
+		&& surface.Font == pFont
+		&& surface.Padding == pad
+		&& surface.bKerning == request.Kerning
+		&& surface.bShowLineMetrics == request.ShowLineMetrics;
+
+	std::vector<size_t> dirtyLines;
+	if (bIncremental) {
+		// Glyphs may stick out of their line, so neighbors of a changed line get drawn again too.
+		std::vector<bool> dirty(lines.size());
+		for (size_t i = 0, i_ = (std::max)(lines.size(), surface.Lines.size()); i < i_; i++) {
+			if (i < lines.size() && i < surface.Lines.size() && lines[i] == surface.Lines[i])
+				continue;
+			for (auto j = i == 0 ? 0 : i - 1; j <= i + 1 && j < lines.size(); j++)
+				dirty[j] = true;
+		}
+		for (size_t i = 0; i < lines.size(); i++) {
+			if (dirty[i])
+				dirtyLines.emplace_back(i);
+		}
+	} else {
+		for (size_t i = 0; i < lines.size(); i++)
+			dirtyLines.emplace_back(i);
+	}
+
+	// Lines below the bottom border will not be visible.
+	std::erase_if(dirtyLines, [&](size_t i) { return pad + static_cast<int>(i) * lineHeight >= mipmap.Height - pad; });
+
+	m_nFrameCounter++;
+	const auto maxWidth = request.WordWrap ? mipmap.Width - pad * 2 : (std::numeric_limits<int>::max)();
+
+	std::vector<MeasuredText*> measuredLines;
+	measuredLines.reserve(dirtyLines.size());
+	for (const auto i : dirtyLines)
+		measuredLines.emplace_back(&Measure(pFont, lines[i], maxWidth, request.Kerning));
+
+	// Lines left as they are still show their layouts, which a full redraw will need again.
+	if (bIncremental) {
+		for (size_t i = 0; i < lines.size() && pad + static_cast<int>(i) * lineHeight < mipmap.Height - pad; i++) {
+			if (!std::ranges::binary_search(dirtyLines, i))
+				Touch(pFont, lines[i], maxWidth, request.Kerning);
+		}
+	}
+
+	if (IsSuperseded(requestId))
+		return nullptr;
+
+	surface.bValid = false;
+	surface.Font = pFont;
+	surface.Padding = pad;
+	surface.LineHeight = lineHeight;
+	surface.Ascent = ascent;
+	surface.bKerning = request.Kerning;
+	surface.bShowLineMetrics = request.ShowLineMetrics;
+
+	if (!bIncremental) {
+		FillRows(surface, 0, mipmap.Height);
+	} else {
+		for (const auto i : dirtyLines)
+			FillRows(surface, pad + static_cast<int>(i) * lineHeight, pad + static_cast<int>(i + 1) * lineHeight);
+
+		// The text got shorter; clear what the removed lines used to occupy.
+		if (surface.Lines.size() > lines.size())
+			FillRows(surface, pad + static_cast<int>(lines.size()) * lineHeight, pad + static_cast<int>(surface.Lines.size()) * lineHeight);
+	}
+
+	if (pFont) {
+		if (!lines.empty()) {
+			for (size_t j = 0; j < dirtyLines.size(); j++)
+				measuredLines[j]->draw_to(mipmap, *pFont, pad, pad + static_cast<int>(dirtyLines[j]) * lineHeight, { 0xFF, 0xFF, 0xFF, 0xFF }, { 0, 0, 0, 0 });
+		} else if (!request.Face->PreviewText.empty()) {
+			Measure(pFont, request.Face->PreviewText, maxWidth, request.Kerning)
+				.draw_to(mipmap, *pFont, pad, pad, { 0xFF, 0xFF, 0xFF, 0xFF }, { 0, 0, 0, 0 });
+		}
+	}
+
+	surface.Lines = std::move(lines);
+	surface.bValid = true;
+
+	TrimLayouts();
+
+	return frame;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Structs.h"
+
+namespace App {
+	// Renders the preview of a face on a worker thread, so that loading fonts and drawing long texts do not block the window.
+	// Only the most recent request gets rendered; an older one still in progress is abandoned at the next checkpoint.
+	// Surfaces are reused across frames, and without word wrapping only the lines that changed get drawn again.
+	class PreviewRenderer {
+	public:
+		struct Request {
+			// Copy of the face, so that the face being edited can change while rendering.
+			std::shared_ptr<Structs::Face> Face;
+
+			// The face the copy has been made from; only used for identification.
+			const Structs::Face* SourceFace = nullptr;
+
+			int Width = 1;
+			int Height = 1;
+			int Padding = 0;
+			bool WordWrap = false;
+			bool Kerning = false;
+			bool ShowLineMetrics = true;
+		};
+
+		struct Frame {
+			std::shared_ptr<xivres::texture::memory_mipmap_stream> Mipmap;
+
+			// The copy of the face, now with the fonts created for rendering.
+			std::shared_ptr<Structs::Face> Face;
+			const Structs::Face* SourceFace = nullptr;
+		};
+
+	private:
+		using MeasuredText = std::remove_cvref_t<decltype(std::declval<xivres::fontgen::text_measurer&>().measure(std::declval<const std::string&>()))>;
+
+		// Inputs that decide the layout of a text; view options such as zoom or line metrics do not affect it.
+		struct LayoutKey {
+			const xivres::fontgen::fixed_size_font* Font;
+			std::string Text;
+			int MaxWidth;
+			bool Kerning;
+
+			auto operator<=>(const LayoutKey&) const = default;
+		};
+
+		struct LayoutEntry {
+			// Keeps the font alive, so that the address in the key does not get reused by another font.
+			std::shared_ptr<xivres::fontgen::fixed_size_font> Font;
+			MeasuredText Measured;
+			uint64_t LastUsedFrame = 0;
+		};
+
+		static constexpr size_t MaxLayoutCacheEntries = 4096;
+
+		// Every entry keeps its font alive along with the fonts and font data it has been made from, so keep only a few fonts.
+		static constexpr size_t MaxLayoutCacheFonts = 4;
+
+		// Mipmap kept across frames, along with what has been drawn on it.
+		struct Surface {
+			std::shared_ptr<xivres::texture::memory_mipmap_stream> Mipmap;
+			bool bValid = false;
+
+			std::shared_ptr<xivres::fontgen::fixed_size_font> Font;
+			int Padding = 0;
+			int LineHeight = 0;
+			int Ascent = 0;
+			bool bKerning = false;
+			bool bShowLineMetrics = false;
+
+			// Each line drawn separately, or empty if the whole text has been drawn at once.
+			std::vector<std::string> Lines;
+		};
+
+		const HWND m_hNotifyWnd;
+		const UINT m_nNotifyMessage;
+
+		mutable std::mutex m_mtx;
+		std::condition_variable m_cv;
+		std::optional<Request> m_pendingRequest;
+		uint64_t m_nLatestRequestId = 0;
+		std::shared_ptr<const Frame> m_latestFrame;
+		bool m_bQuit = false;
+		bool m_bPaused = false;
+		bool m_bRendering = false;
+
+		// Only touched from the worker, but guarded by m_mtx, as reference counts of the mipmaps are checked against frames being painted.
+		std::vector<std::shared_ptr<Surface>> m_surfaces;
+
+		// Only touched from the worker.
+		std::map<LayoutKey, LayoutEntry> m_layouts;
+		uint64_t m_nFrameCounter = 0;
+
+		std::thread m_thread;
+
+	public:
+		// Post the given message to the window whenever a new frame becomes available.
+		PreviewRenderer(HWND hNotifyWnd, UINT nNotifyMessage);
+		PreviewRenderer(PreviewRenderer&&) = delete;
+		PreviewRenderer(const PreviewRenderer&) = delete;
+		PreviewRenderer operator=(PreviewRenderer&&) = delete;
+		PreviewRenderer operator=(const PreviewRenderer&) = delete;
+		~PreviewRenderer();
+
+		// Replace any request that has not been rendered yet.
+		void Submit(Request request);
+
+		[[nodiscard]] std::shared_ptr<const Frame> GetLatestFrame() const;
+
+		// Abandon the frame in progress and wait for the worker to let go of it, so that fonts shared with the face being edited
+		// are not used from the worker until Resume gets called. Requests submitted meanwhile are rendered after resuming.
+		void Pause();
+
+		void Resume();
+
+		[[nodiscard]] bool IsPaused() const;
+
+	private:
+		void Worker();
+
+		[[nodiscard]] bool IsSuperseded(uint64_t requestId) const;
+
+		// Get a surface that is neither the latest frame nor being painted, sized as requested.
+		std::shared_ptr<Surface> AcquireSurface(int width, int height);
+
+		// Get the layout of the text from the cache, measuring it if not found.
+		MeasuredText& Measure(const std::shared_ptr<xivres::fontgen::fixed_size_font>& pFont, const std::string& text, int maxWidth, bool kerning);
+
+		// Mark the layout of the text as used in this frame if cached, as it is still on the surface.
+		void Touch(const std::shared_ptr<xivres::fontgen::fixed_size_font>& pFont, const std::string& text, int maxWidth, bool kerning);
+
+		// Remove layouts of fonts other than the few most recently used ones, and then layouts not used in this frame if there are too many.
+		void TrimLayouts();
+
+		// Fill rows in [y1, y2) with the border, background, and line metrics bands.
+		static void FillRows(Surface& surface, int y1, int y2);
+
+		// Returns null if a newer request came in while rendering.
+		std::shared_ptr<Frame> Render(const Request& request, uint64_t requestId);
+	};
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "FontSetExporter.h"
+
 namespace App {
-	class ProgressDialog {
+	class ProgressDialog : public ExportProgress {
 		struct ControlStruct;
 
 		const HWND m_hParentWnd;
@@ -17,21 +19,21 @@ namespace App {
 	public:
 		ProgressDialog(HWND hParentWnd, std::wstring windowTitle);
 
-		~ProgressDialog();
+		~ProgressDialog() override;
 
 		class ProgressDialogCancelledError : public std::runtime_error {
 		public:
 			ProgressDialogCancelledError() : std::runtime_error("Cancelled by user") {}
 		};
 
-		void ThrowIfCancelled() const;
+		void ThrowIfCancelled() const override;
 
-		bool IsCancelled() const;
+		bool IsCancelled() const override;
 
 		void UpdateStatusMessage(const std::wstring& s);
-		void UpdateStatusMessage(std::wstring_view s);
+		void UpdateStatusMessage(std::wstring_view s) override;
 
-		void UpdateProgress(float progress);
+		void UpdateProgress(float progress) override;
 
 	private:
 		INT_PTR Dialog_OnInitDialog();
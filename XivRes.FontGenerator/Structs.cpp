@@ -1,9 +1,30 @@
 ﻿#include "pch.h"
 #include "Structs.h"
 
+#include "FontFamilyCatalogue.h"
 #include "FontGeneratorConfig.h"
+#include "FontIndex.h"
+#include "MappedFileStream.h"
 #include "resource.h"
 
+// Font family names are looked up case-insensitively, so differently cased names should make the same key.
+static std::string GetFamilyNameKey(std::string name) {
+	for (auto& c : name) {
+		if ('A' <= c && c <= 'Z')
+			c += 'a' - 'A';
+	}
+	return name;
+}
+
+// Compare field by field, instead of serializing both to JSON on every comparison.
+static bool AreWrapModifiersEqual(const xivres::fontgen::wrap_modifiers& l, const xivres::fontgen::wrap_modifiers& r) {
+	return l.Codepoints == r.Codepoints
+		&& l.LetterSpacing == r.LetterSpacing
+		&& l.HorizontalOffset == r.HorizontalOffset
+		&& l.BaselineShift == r.BaselineShift
+		&& l.CodepointReplacements == r.CodepointReplacements;
+}
+
 std::shared_ptr<xivres::fontgen::fixed_size_font> GetGameFont(xivres::fontgen::game_font_family family, float size) {
 	static std::map<xivres::font_type, xivres::fontgen::game_fontdata_set> s_fontSet;
 	static std::mutex s_mtx;
@@ -153,11 +174,8 @@ std::wstring App::Structs::LookupStruct::GetStyleString() const {
 std::pair<IDWriteFactoryPtr, IDWriteFontPtr> App::Structs::LookupStruct::ResolveFont() const {
 	using namespace xivres::fontgen;
 
-	IDWriteFactoryPtr factory;
-	SuccessOrThrow(DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), reinterpret_cast<IUnknown**>(&factory)));
-
-	IDWriteFontCollectionPtr coll;
-	SuccessOrThrow(factory->GetSystemFontCollection(&coll));
+	IDWriteFactoryPtr factory(FontFamilyCatalogue::GetFactory());
+	const auto& coll = FontFamilyCatalogue::GetSystemFontCollection();
 
 	uint32_t index;
 	BOOL exists;
@@ -174,6 +192,29 @@ std::pair<IDWriteFactoryPtr, IDWriteFontPtr> App::Structs::LookupStruct::Resolve
 	return std::make_pair(std::move(factory), std::move(font));
 }
 
+// Get the path of the font file if it comes from the file system, or an empty path otherwise.
+static std::filesystem::path GetLocalFontFilePath(IDWriteFontFile* file) {
+	using namespace xivres::fontgen;
+
+	IDWriteFontFileLoaderPtr loader;
+	void const* refKey;
+	UINT32 refKeySize;
+	IDWriteLocalFontFileLoaderPtr localLoader;
+	UINT32 pathLength;
+	if (FAILED(file->GetLoader(&loader))
+		|| FAILED(file->GetReferenceKey(&refKey, &refKeySize))
+		|| FAILED(loader->QueryInterface(IID_PPV_ARGS(&localLoader)))
+		|| FAILED(localLoader->GetFilePathLengthFromKey(refKey, refKeySize, &pathLength)))
+		return {};
+
+	std::wstring path(pathLength + 1, L'\0');
+	if (FAILED(localLoader->GetFilePathFromKey(refKey, refKeySize, path.data(), pathLength + 1)))
+		return {};
+
+	path.resize(pathLength);
+	return path;
+}
+
 std::pair<std::shared_ptr<xivres::stream>, int> App::Structs::LookupStruct::ResolveStream() const {
 	using namespace xivres::fontgen;
 
@@ -187,6 +228,15 @@ std::pair<std::shared_ptr<xivres::stream>, int> App::Structs::LookupStruct::Reso
 	SuccessOrThrow(face->GetFiles(&nFiles, &pFontFileTmp));
 	IDWriteFontFilePtr file(pFontFileTmp, false);
 
+	// Map fonts from the file system directly, so that every element using the same file shares the same memory.
+	if (const auto path = GetLocalFontFilePath(file); !path.empty()) {
+		try {
+			return {MappedFileStream::Open(path), face->GetIndex()};
+		} catch (const std::system_error&) {
+			// Fall back to reading through DirectWrite.
+		}
+	}
+
 	IDWriteFontFileLoaderPtr loader;
 	SuccessOrThrow(file->GetLoader(&loader));
 
@@ -197,7 +247,6 @@ std::pair<std::shared_ptr<xivres::stream>, int> App::Structs::LookupStruct::Reso
 	IDWriteFontFileStreamPtr stream;
 	SuccessOrThrow(loader->CreateStreamFromKey(refKey, refKeySize, &stream));
 
-	auto res = std::make_shared<xivres::memory_stream>();
 	uint64_t fileSize;
 	SuccessOrThrow(stream->GetFileSize(&fileSize));
 	const void* pFragmentStart;
@@ -210,6 +259,49 @@ std::pair<std::shared_ptr<xivres::stream>, int> App::Structs::LookupStruct::Reso
 	return {std::make_shared<xivres::memory_stream>(std::move(buf)), face->GetIndex()};
 }
 
+std::pair<std::shared_ptr<xivres::stream>, int> App::Structs::LookupStruct::ResolveFreeTypeStream() const {
+	if (!g_config.FontDirectories.empty()) {
+		if (const auto face = FontIndex::GetInstance().Find(Name, Weight, Stretch, Style)) {
+			try {
+				return {MappedFileStream::Open(face->Path), face->Index};
+			} catch (const std::system_error&) {
+				// The file is gone since it was indexed; try the system fonts.
+			}
+		}
+	}
+
+	return ResolveStream();
+}
+
+std::pair<std::filesystem::path, int> App::Structs::LookupStruct::ResolveFilePath(bool bFreeType) const {
+	if (bFreeType && !g_config.FontDirectories.empty()) {
+		if (const auto face = FontIndex::GetInstance().Find(Name, Weight, Stretch, Style); face && exists(face->Path))
+			return {face->Path, face->Index};
+	}
+
+	using namespace xivres::fontgen;
+
+	auto [factory, font] = ResolveFont();
+
+	IDWriteFontFacePtr face;
+	SuccessOrThrow(font->CreateFontFace(&face));
+
+	IDWriteFontFile* pFontFileTmp;
+	uint32_t nFiles = 1;
+	SuccessOrThrow(face->GetFiles(&nFiles, &pFontFileTmp));
+	IDWriteFontFilePtr file(pFontFileTmp, false);
+
+	return {GetLocalFontFilePath(file), face->GetIndex()};
+}
+
+std::string App::Structs::LookupStruct::GetSourceKey() const {
+	return std::format("{}:{}:{}:{}",
+		GetFamilyNameKey(Name),
+		static_cast<uint32_t>(Weight),
+		static_cast<uint32_t>(Stretch),
+		static_cast<uint32_t>(Style));
+}
+
 const std::shared_ptr<xivres::fontgen::fixed_size_font>& App::Structs::FaceElement::GetBaseFont() const {
 	if (!m_baseFont) {
 		try {
@@ -252,7 +344,7 @@ const std::shared_ptr<xivres::fontgen::fixed_size_font>& App::Structs::FaceEleme
 				}
 
 				case RendererEnum::FreeType: {
-					auto [pStream, index] = Lookup.ResolveStream();
+					auto [pStream, index] = Lookup.ResolveFreeTypeStream();
 					m_baseFont = std::make_shared<xivres::fontgen::freetype_fixed_size_font>(*pStream, index, Size, Gamma, TransformationMatrix, RendererSpecific.FreeType);
 					break;
 				}
@@ -272,17 +364,132 @@ const std::shared_ptr<xivres::fontgen::fixed_size_font>& App::Structs::FaceEleme
 
 const std::shared_ptr<xivres::fontgen::fixed_size_font>& App::Structs::FaceElement::GetWrappedFont() const {
 	if (!m_wrappedFont)
-		m_wrappedFont = std::make_shared<xivres::fontgen::wrapping_fixed_size_font>(GetBaseFont(), WrapModifiers);
+		m_wrappedFont = std::make_shared<xivres::fontgen::wrapping_fixed_size_font>(m_wrappedFontSource ? m_wrappedFontSource : GetBaseFont(), WrapModifiers);
 
 	return m_wrappedFont;
 }
 
+// Read the codepoints from the character map of the font file, without creating a font at any size.
+static std::vector<char32_t> ReadCodepoints(const App::Structs::LookupStruct& lookup, bool bFreeType) {
+	const auto [pStream, index] = bFreeType ? lookup.ResolveFreeTypeStream() : lookup.ResolveStream();
+
+	std::vector<uint8_t> buf;
+	std::span<const uint8_t> data;
+	if (const auto pMapped = dynamic_cast<const App::MappedFileStream*>(pStream.get())) {
+		data = pMapped->as_span();
+	} else {
+		buf.resize(static_cast<size_t>(pStream->size()));
+		for (size_t read, pos = 0; pos < buf.size() && (read = pStream->read(pos, &buf[pos], buf.size() - pos)); pos += read) {}
+		data = buf;
+	}
+
+	FT_Library library;
+	if (FT_Init_FreeType(&library))
+		throw std::runtime_error("Failed to initialize FreeType");
+	const auto doneLibrary = xivres::util::on_dtor([library]() { FT_Done_FreeType(library); });
+
+	FT_Face face;
+	if (FT_New_Memory_Face(library, data.data(), static_cast<FT_Long>(data.size()), index, &face))
+		throw std::runtime_error("Failed to open font");
+	const auto doneFace = xivres::util::on_dtor([face]() { FT_Done_Face(face); });
+
+	std::vector<char32_t> res;
+	FT_UInt glyphIndex;
+	for (auto c = FT_Get_First_Char(face, &glyphIndex); glyphIndex; c = FT_Get_Next_Char(face, c, &glyphIndex))
+		res.emplace_back(static_cast<char32_t>(c));
+	return res;
+}
+
+std::shared_ptr<const App::Structs::FaceElement::SharedFaceData> App::Structs::FaceElement::GetSharedFaceData() const {
+	if (m_sharedFaceData)
+		return m_sharedFaceData;
+
+	auto pData = std::make_shared<SharedFaceData>();
+	const auto createData = [this, &pData]() {
+		pData->Codepoints = CodepointSet(GetBaseFont()->all_codepoints());
+	};
+
+	switch (Renderer) {
+		case RendererEnum::DirectWrite:
+		case RendererEnum::FreeType: {
+			// Codepoints come from the character map of the font file, which stays the same across sizes and renderers.
+			static std::mutex s_mtx;
+			static std::map<std::string, std::weak_ptr<const SharedFaceData>> s_sharedData;
+
+			// FreeType may be reading a different file from what DirectWrite would use.
+			auto key = Lookup.GetSourceKey();
+			if (Renderer == RendererEnum::FreeType && !g_config.FontDirectories.empty())
+				key = "freetype:" + key;
+			{
+				const auto lock = std::lock_guard(s_mtx);
+				if (const auto it = s_sharedData.find(key); it != s_sharedData.end()) {
+					if ((m_sharedFaceData = it->second.lock()))
+						return m_sharedFaceData;
+				}
+			}
+
+			// Read the character map from the file, instead of creating a font at the size of this element only to list its codepoints.
+			try {
+				pData->Codepoints = CodepointSet(ReadCodepoints(Lookup, Renderer == RendererEnum::FreeType));
+			} catch (const std::exception&) {
+				createData();
+			}
+
+			// Do not share the result of a font that failed to load.
+			if (pData->Codepoints.IsEmpty())
+				return m_sharedFaceData = std::move(pData);
+
+			const auto lock = std::lock_guard(s_mtx);
+			std::erase_if(s_sharedData, [](const auto& pair) { return pair.second.expired(); });
+			auto& pWeak = s_sharedData[key];
+			if ((m_sharedFaceData = pWeak.lock()))
+				return m_sharedFaceData;
+
+			pWeak = pData;
+			return m_sharedFaceData = std::move(pData);
+		}
+
+		default:
+			// Game fonts have different sets of glyphs for each size.
+			createData();
+			return m_sharedFaceData = std::move(pData);
+	}
+}
+
+void App::Structs::FaceElement::SetWrappedFontSource(std::shared_ptr<xivres::fontgen::fixed_size_font> font) const {
+	if (m_wrappedFontSource == font)
+		return;
+
+	m_wrappedFontSource = std::move(font);
+	m_wrappedFont = nullptr;
+}
+
+void App::Structs::FaceElement::AdoptFontsFrom(const FaceElement& r) const {
+	if (!m_baseFont && r.m_baseFont && GetBaseFontKey() == r.GetBaseFontKey()) {
+		m_baseFont = r.m_baseFont;
+		if (!m_sharedFaceData)
+			m_sharedFaceData = r.m_sharedFaceData;
+	}
+
+	if (m_wrappedFont || !r.m_wrappedFont || m_wrappedFontSource != r.m_wrappedFontSource)
+		return;
+	if (!m_wrappedFontSource && m_baseFont != r.m_baseFont)
+		return;
+	if (!AreWrapModifiersEqual(WrapModifiers, r.WrapModifiers))
+		return;
+
+	m_wrappedFont = r.m_wrappedFont;
+}
+
 void App::Structs::FaceElement::OnFontWrappingParametersChange() {
 	m_wrappedFont = nullptr;
+	m_wrappedFontSource = nullptr;
 }
 
 void App::Structs::FaceElement::OnFontCreateParametersChange() {
+	m_sharedFaceData = nullptr;
 	m_wrappedFont = nullptr;
+	m_wrappedFontSource = nullptr;
 	m_baseFont = nullptr;
 }
 
@@ -293,13 +500,10 @@ std::string App::Structs::FaceElement::GetBaseFontKey() const {
 		case RendererEnum::PrerenderedGameInstallation:
 			return std::format("game:{}:{:g}", Lookup.Name, Size);
 		case RendererEnum::DirectWrite: {
-			auto res = std::format("directwrite:{}:{:g}:{:g}:{}:{}:{}:{}:{}:{}:{:08X}{:08X}{:08X}{:08X}",
-				Lookup.Name,
+			auto res = std::format("directwrite:{}:{:g}:{:g}:{}:{}:{}:{:08X}{:08X}{:08X}{:08X}",
+				Lookup.GetSourceKey(),
 				Size,
 				Gamma,
-				static_cast<uint32_t>(Lookup.Weight),
-				static_cast<uint32_t>(Lookup.Stretch),
-				static_cast<uint32_t>(Lookup.Style),
 				static_cast<uint32_t>(RendererSpecific.DirectWrite.RenderMode),
 				static_cast<uint32_t>(RendererSpecific.DirectWrite.MeasureMode),
 				static_cast<uint32_t>(RendererSpecific.DirectWrite.GridFitMode),
@@ -313,14 +517,12 @@ std::string App::Structs::FaceElement::GetBaseFontKey() const {
 			return res;
 		}
 		case RendererEnum::FreeType:
-			return std::format("freetype:{}:{:g}:{:g}:{}:{}:{}:{}:{:08X}{:08X}{:08X}{:08X}",
-				Lookup.Name,
+			return std::format("freetype:{}:{:g}:{:g}:{}:{}:{:08X}{:08X}{:08X}{:08X}",
+				Lookup.GetSourceKey(),
 				Size,
 				Gamma,
-				static_cast<uint32_t>(Lookup.Weight),
-				static_cast<uint32_t>(Lookup.Stretch),
-				static_cast<uint32_t>(Lookup.Style),
 				static_cast<uint32_t>(RendererSpecific.FreeType.LoadFlags),
+				static_cast<uint32_t>(RendererSpecific.FreeType.RenderMode),
 				*reinterpret_cast<const uint32_t*>(&TransformationMatrix.M11),
 				*reinterpret_cast<const uint32_t*>(&TransformationMatrix.M12),
 				*reinterpret_cast<const uint32_t*>(&TransformationMatrix.M21),
@@ -336,14 +538,12 @@ std::wstring App::Structs::FaceElement::GetRangeRepresentation() const {
 		return L"(None)";
 
 	std::wstring res;
-	std::vector<char32_t> charVec(GetBaseFont()->all_codepoints().begin(), GetBaseFont()->all_codepoints().end());
+	const auto pFaceData = GetSharedFaceData();
 	for (const auto& [c1, c2] : WrapModifiers.Codepoints) {
 		if (!res.empty())
 			res += L", ";
 
-		const auto left = std::ranges::lower_bound(charVec, c1);
-		const auto right = std::ranges::upper_bound(charVec, c2);
-		const auto count = right - left;
+		const auto count = pFaceData->Codepoints.Count(c1, c2);
 
 		const auto blk = std::lower_bound(xivres::util::unicode::blocks::all_blocks().begin(), xivres::util::unicode::blocks::all_blocks().end(), c1, [](const auto& l, const auto& r) { return l.First < r; });
 		if (blk != xivres::util::unicode::blocks::all_blocks().end() && blk->First == c1 && blk->Last == c2) {
@@ -415,7 +615,9 @@ App::Structs::FaceElement::FaceElement(FaceElement&& r) noexcept : FaceElement()
 }
 
 App::Structs::FaceElement::FaceElement(const FaceElement& r)
-	: m_baseFont(r.m_baseFont)
+	: m_sharedFaceData(r.m_sharedFaceData)
+	, m_baseFont(r.m_baseFont)
+	, m_wrappedFontSource(r.m_wrappedFontSource)
 	, m_wrappedFont(r.m_wrappedFont)
 	, Size(r.Size)
 	, Gamma(r.Gamma)
@@ -442,7 +644,9 @@ void App::Structs::swap(FaceElement& l, FaceElement& r) noexcept {
 		return;
 
 	using std::swap;
+	swap(l.m_sharedFaceData, r.m_sharedFaceData);
 	swap(l.m_baseFont, r.m_baseFont);
+	swap(l.m_wrappedFontSource, r.m_wrappedFontSource);
 	swap(l.m_wrappedFont, r.m_wrappedFont);
 	swap(l.Size, r.Size);
 	swap(l.Gamma, r.Gamma);
@@ -455,20 +659,42 @@ void App::Structs::swap(FaceElement& l, FaceElement& r) noexcept {
 }
 
 const std::shared_ptr<xivres::fontgen::fixed_size_font>& App::Structs::Face::GetMergedFont() const {
-	if (!MergedFont) {
-		std::vector<std::pair<std::shared_ptr<xivres::fontgen::fixed_size_font>, xivres::fontgen::codepoint_merge_mode>> mergeFontList;
+	std::vector<std::pair<std::shared_ptr<xivres::fontgen::fixed_size_font>, xivres::fontgen::codepoint_merge_mode>> mergeFontList;
 
-		for (auto& pElement : Elements)
-			mergeFontList.emplace_back(pElement->GetWrappedFont(), pElement->MergeMode);
+	for (auto& pElement : Elements)
+		mergeFontList.emplace_back(pElement->GetWrappedFont(), pElement->MergeMode);
 
+	// Elements may get changed or replaced without this face being notified, so keep the merged font only if it is made from the same fonts.
+	if (!MergedFont || mergeFontList != MergedFontSources) {
+		MergedFontSources = mergeFontList;
 		MergedFont = std::make_shared<xivres::fontgen::merged_fixed_size_font>(std::move(mergeFontList));
 	}
 
 	return MergedFont;
 }
 
+void App::Structs::Face::AdoptFontsFrom(const Face& r) const {
+	if (Elements.size() != r.Elements.size())
+		return;
+
+	for (size_t i = 0; i < Elements.size(); i++)
+		Elements[i]->AdoptFontsFrom(*r.Elements[i]);
+
+	if (!r.MergedFont || MergedFont == r.MergedFont || r.MergedFontSources.size() != Elements.size())
+		return;
+
+	for (size_t i = 0; i < Elements.size(); i++) {
+		if (Elements[i]->m_wrappedFont != r.MergedFontSources[i].first || Elements[i]->MergeMode != r.MergedFontSources[i].second)
+			return;
+	}
+
+	MergedFont = r.MergedFont;
+	MergedFontSources = r.MergedFontSources;
+}
+
 void App::Structs::Face::OnElementChange() {
 	MergedFont = nullptr;
+	MergedFontSources.clear();
 }
 
 App::Structs::Face::Face() noexcept = default;
@@ -479,6 +705,8 @@ App::Structs::Face::Face(Face&& r) noexcept : Face() {
 
 App::Structs::Face::Face(const Face& r)
 	: MergedFont(r.MergedFont)
+	, MergedFontSources(r.MergedFontSources)
+	, Name(r.Name)
 	, PreviewText(r.PreviewText) {
 	Elements.reserve(r.Elements.size());
 	for (const auto& e : r.Elements)
@@ -513,16 +741,34 @@ void App::Structs::FontSet::ConsolidateFonts() const {
 			auto& elem = *pElem;
 			auto& known = loadedBaseFonts[elem.GetBaseFontKey()];
 			if (known) {
-				elem.m_baseFont = known;
+				// Keep the wrapped font and anything made from it, unless the base font actually gets replaced.
+				if (elem.m_baseFont != known) {
+					elem.m_baseFont = known;
+					elem.m_wrappedFont = nullptr;
+				}
 			} else if (elem.m_baseFont) {
 				known = elem.m_baseFont;
 			} else {
 				known = elem.GetBaseFont();
 			}
-			elem.OnFontWrappingParametersChange();
 		}
+	}
+}
 
-		pFace->OnElementChange();
+void App::Structs::FontSet::ShareWrappedFonts() const {
+	// Wrapped fonts made so far from each source font, along with the modifiers they have been made with.
+	std::map<const xivres::fontgen::fixed_size_font*, std::vector<std::pair<const xivres::fontgen::wrap_modifiers*, std::shared_ptr<xivres::fontgen::fixed_size_font>>>> wrappedFonts;
+	for (const auto& pFace : Faces) {
+		for (const auto& pElem : pFace->Elements) {
+			auto& elem = *pElem;
+			const auto& source = elem.m_wrappedFontSource ? elem.m_wrappedFontSource : elem.GetBaseFont();
+			auto& candidates = wrappedFonts[source.get()];
+			const auto it = std::ranges::find_if(candidates, [&elem](const auto& pair) { return AreWrapModifiersEqual(*pair.first, elem.WrapModifiers); });
+			if (it == candidates.end())
+				candidates.emplace_back(&elem.WrapModifiers, elem.GetWrappedFont());
+			else if (elem.m_wrappedFont != it->second)
+				elem.m_wrappedFont = it->second;
+		}
 	}
 }
 
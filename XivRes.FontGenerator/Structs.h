@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include "CodepointSet.h"
+
 namespace App::Structs {
 	enum class RendererEnum : uint8_t {
 		Empty,
@@ -26,6 +28,17 @@ namespace App::Structs {
 
 		std::pair<IDWriteFactoryPtr, IDWriteFontPtr> ResolveFont() const;
 		std::pair<std::shared_ptr<xivres::stream>, int> ResolveStream() const;
+
+		// Look in FontGeneratorConfig::FontDirectories first, and then in the fonts installed to the system.
+		std::pair<std::shared_ptr<xivres::stream>, int> ResolveFreeTypeStream() const;
+
+		// Get the path and face index of the file that ResolveStream or ResolveFreeTypeStream would read, without reading it.
+		// Path is empty if the font does not come from a local file.
+		std::pair<std::filesystem::path, int> ResolveFilePath(bool bFreeType) const;
+
+		// Get a key identifying the font file being looked up, regardless of the features.
+		// Family names are looked up case-insensitively, so the name is case-folded here; other keys of the font should be made from this one.
+		std::string GetSourceKey() const;
 	};
 
 	struct RendererSpecificStruct {
@@ -35,9 +48,20 @@ namespace App::Structs {
 	};
 
 	class FaceElement {
+	public:
+		// Data of the font that does not depend on the size, shared between the elements using the same font file.
+		struct SharedFaceData {
+			// Codepoints available from the base font.
+			CodepointSet Codepoints;
+		};
+
+	private:
+		mutable std::shared_ptr<const SharedFaceData> m_sharedFaceData;
 		mutable std::shared_ptr<xivres::fontgen::fixed_size_font> m_baseFont;
+		mutable std::shared_ptr<xivres::fontgen::fixed_size_font> m_wrappedFontSource;
 		mutable std::shared_ptr<xivres::fontgen::fixed_size_font> m_wrappedFont;
 		friend struct FontSet;
+		friend class Face;
 
 	public:
 		float Size = 0.f;
@@ -60,6 +84,15 @@ namespace App::Structs {
 		const std::shared_ptr<xivres::fontgen::fixed_size_font>& GetBaseFont() const;
 		const std::shared_ptr<xivres::fontgen::fixed_size_font>& GetWrappedFont() const;
 
+		std::shared_ptr<const SharedFaceData> GetSharedFaceData() const;
+
+		// Wrap the given font instead of the base font, until any parameter changes.
+		// The font must draw the same as the base font for all codepoints in WrapModifiers.
+		void SetWrappedFontSource(std::shared_ptr<xivres::fontgen::fixed_size_font> font) const;
+
+		// Take the fonts created in a copy of this element, if they are what this element would create.
+		void AdoptFontsFrom(const FaceElement& r) const;
+
 		void OnFontWrappingParametersChange();
 		void OnFontCreateParametersChange();
 
@@ -74,6 +107,7 @@ namespace App::Structs {
 
 	class Face {
 		mutable std::shared_ptr<xivres::fontgen::fixed_size_font> MergedFont;
+		mutable std::vector<std::pair<std::shared_ptr<xivres::fontgen::fixed_size_font>, xivres::fontgen::codepoint_merge_mode>> MergedFontSources;
 
 	public:
 		std::string Name;
@@ -90,6 +124,9 @@ namespace App::Structs {
 
 		const std::shared_ptr<xivres::fontgen::fixed_size_font>& GetMergedFont() const;
 
+		// Take the fonts created in a copy of this face, for the elements that have not changed since the copy was made.
+		void AdoptFontsFrom(const Face& r) const;
+
 		void OnElementChange();
 	};
 
@@ -104,6 +141,10 @@ namespace App::Structs {
 
 		void ConsolidateFonts() const;
 
+		// Make elements that wrap the same font with the same modifiers use one wrapped font.
+		// Faces then merge from the same fonts wherever they show the same glyphs, so the packer draws such glyphs once.
+		void ShareWrappedFonts() const;
+
 		static FontSet NewFromTemplateFont(xivres::font_type fontType);
 	};
 
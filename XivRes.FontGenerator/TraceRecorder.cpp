@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "TraceRecorder.h"
+
+App::TraceRecorder::Scope::Scope(TraceRecorder* recorder, std::string name, std::string category, nlohmann::json args)
+	: m_recorder(recorder) {
+	if (!m_recorder)
+		return;
+
+	m_name = std::move(name);
+	m_category = std::move(category);
+	m_args = std::move(args);
+	m_begin = clock::now();
+}
+
+App::TraceRecorder::Scope::Scope(Scope&& r) noexcept
+	: m_recorder(r.m_recorder)
+	, m_name(std::move(r.m_name))
+	, m_category(std::move(r.m_category))
+	, m_args(std::move(r.m_args))
+	, m_begin(r.m_begin) {
+	r.m_recorder = nullptr;
+}
+
+App::TraceRecorder::Scope& App::TraceRecorder::Scope::operator=(Scope&& r) noexcept {
+	if (this == &r)
+		return *this;
+
+	End();
+	m_recorder = r.m_recorder;
+	m_name = std::move(r.m_name);
+	m_category = std::move(r.m_category);
+	m_args = std::move(r.m_args);
+	m_begin = r.m_begin;
+	r.m_recorder = nullptr;
+	return *this;
+}
+
+App::TraceRecorder::Scope::~Scope() {
+	End();
+}
+
+void App::TraceRecorder::Scope::End() {
+	if (!m_recorder)
+		return;
+
+	m_recorder->Record(std::move(m_name), std::move(m_category), std::move(m_args), m_begin, clock::now());
+	m_recorder = nullptr;
+}
+
+void App::TraceRecorder::Record(std::string name, std::string category, nlohmann::json args, clock::time_point begin, clock::time_point end) {
+	const auto lock = std::lock_guard(m_mtx);
+	m_events.emplace_back(Event{
+		.Name = std::move(name),
+		.Category = std::move(category),
+		.Args = std::move(args),
+		.ThreadId = GetCurrentThreadId(),
+		.Begin = begin,
+		.End = end,
+	});
+}
+
+void App::TraceRecorder::WriteChromeTrace(const std::filesystem::path& path) const {
+	const auto toMicroseconds = [](clock::duration d) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+	};
+
+	auto events = nlohmann::json::array();
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		for (const auto& e : m_events) {
+			auto& j = events.emplace_back(nlohmann::json::object({
+				{"name", e.Name},
+				{"cat", e.Category},
+				{"ph", "X"},
+				{"ts", toMicroseconds(e.Begin - m_begin)},
+				{"dur", toMicroseconds(e.End - e.Begin)},
+				{"pid", GetCurrentProcessId()},
+				{"tid", e.ThreadId},
+			}));
+			if (!e.Args.is_null())
+				j["args"] = e.Args;
+		}
+	}
+
+	std::ofstream out(path);
+	if (!out)
+		throw std::runtime_error(std::format("Failed to create {}", xivres::util::unicode::convert<std::string>(path.wstring())));
+	out << nlohmann::json::object({{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}});
+}
+
+std::vector<App::TraceRecorder::SummaryRow> App::TraceRecorder::Summarize() const {
+	const auto toMilliseconds = [](clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count();
+	};
+
+	std::map<std::string, SummaryRow> rows;
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		for (const auto& e : m_events) {
+			const auto name = std::format("{}/{}", e.Category, e.Name);
+			auto& row = rows[name];
+			row.Name = name;
+			row.Count++;
+			row.TotalMilliseconds += toMilliseconds(e.End - e.Begin);
+			row.MaxMilliseconds = (std::max)(row.MaxMilliseconds, toMilliseconds(e.End - e.Begin));
+		}
+	}
+
+	std::vector<SummaryRow> res;
+	for (auto& row : rows | std::views::values)
+		res.emplace_back(std::move(row));
+	std::ranges::stable_sort(res, [](const auto& l, const auto& r) { return l.TotalMilliseconds > r.TotalMilliseconds; });
+	return res;
+}
+
+std::string App::TraceRecorder::GetSummary() const {
+	auto res = std::format("{:<40} {:>8} {:>14} {:>14}\n", "Event", "Count", "Total (ms)", "Max (ms)");
+	for (const auto& row : Summarize())
+		res += std::format("{:<40} {:>8} {:>14.3f} {:>14.3f}\n", row.Name, row.Count, row.TotalMilliseconds, row.MaxMilliseconds);
+	return res;
+}
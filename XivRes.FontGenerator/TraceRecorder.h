@@ -0,0 +1,61 @@
+#pragma once
+
+namespace App {
+	// Records how long each step of an export takes, to be viewed in chrome://tracing or Perfetto.
+	class TraceRecorder {
+		using clock = std::chrono::steady_clock;
+
+		struct Event {
+			std::string Name;
+			std::string Category;
+			nlohmann::json Args;
+			DWORD ThreadId;
+			clock::time_point Begin;
+			clock::time_point End;
+		};
+
+		const clock::time_point m_begin = clock::now();
+
+		mutable std::mutex m_mtx;
+		std::vector<Event> m_events;
+
+	public:
+		struct SummaryRow {
+			std::string Name;
+			size_t Count = 0;
+			double TotalMilliseconds = 0;
+			double MaxMilliseconds = 0;
+		};
+
+		// Records an event spanning from its construction to its destruction. Does nothing if constructed without a recorder.
+		class Scope {
+			TraceRecorder* m_recorder = nullptr;
+			std::string m_name;
+			std::string m_category;
+			nlohmann::json m_args;
+			clock::time_point m_begin;
+
+		public:
+			Scope() = default;
+			Scope(TraceRecorder* recorder, std::string name, std::string category, nlohmann::json args = {});
+			Scope(Scope&& r) noexcept;
+			Scope(const Scope&) = delete;
+			Scope& operator=(Scope&& r) noexcept;
+			Scope& operator=(const Scope&) = delete;
+			~Scope();
+
+			void End();
+		};
+
+		void Record(std::string name, std::string category, nlohmann::json args, clock::time_point begin, clock::time_point end);
+
+		// Write in Trace Event Format, as complete events.
+		void WriteChromeTrace(const std::filesystem::path& path) const;
+
+		// Get the number of occurrences, total time, and longest time of each event, sorted by total time.
+		std::vector<SummaryRow> Summarize() const;
+
+		// Get Summarize() formatted as a table.
+		std::string GetSummary() const;
+	};
+}
@@ -1,8 +1,10 @@
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 
+#include <bit>
 #include <cmath>
 #include <exception>
+#include <future>
 #include <iostream>
 #include <ranges>
 #include <string>
@@ -20,6 +22,8 @@
 #include <ShellScalingApi.h>
 #include <ShObjIdl.h>
 #include <ShlGuid.h>
+#include <ShlObj.h>
+#include <winioctl.h>
 
 #include <exprtk.hpp>
 
@@ -28,6 +32,9 @@
 #include FT_BITMAP_H
 #include FT_OUTLINE_H
 #include FT_GLYPH_H
+#include FT_SFNT_NAMES_H
+#include FT_TRUETYPE_IDS_H
+#include FT_TRUETYPE_TABLES_H
 
 #include <zlib.h>
 
@@ -68,6 +75,7 @@ _COM_SMARTPTR_TYPEDEF(IShellItem, __uuidof(IShellItem));
 _COM_SMARTPTR_TYPEDEF(IShellItemArray, __uuidof(IShellItemArray));
 _COM_SMARTPTR_TYPEDEF(IDWriteFont, __uuidof(IDWriteFont));
 _COM_SMARTPTR_TYPEDEF(IDWriteFactory, __uuidof(IDWriteFactory));
+_COM_SMARTPTR_TYPEDEF(IDWriteLocalFontFileLoader, __uuidof(IDWriteLocalFontFileLoader));
 
 inline std::wstring GetWindowString(HWND hwnd, bool trim = false) {
 	std::wstring buf(GetWindowTextLengthW(hwnd) + static_cast<size_t>(1), L'\0');
@@ -221,6 +221,15 @@
 #define IDS_OPENTYPEFEATURE_VRT2 322
 #define IDS_OPENTYPEFEATURE_VRTR 323
 #define IDS_OPENTYPEFEATURE_ZERO 324
+#define IDS_EXPORTPROGRESS_GLYPHCACHE   325
+#define IDS_EXPORTPROGRESS_COMPILEDCACHE 326
+#define IDS_EXPORTPROGRESS_COMPRESSING  327
+#define IDS_EXPORTPROGRESS_LAYOUTTRIALS 328
+#define IDS_WINDOWTITLE_OPTIMIZELAYOUT  329
+#define IDS_OPTIMIZELAYOUT_FONTSET      330
+#define IDS_OPTIMIZELAYOUT_TRIAL        331
+#define IDS_OPTIMIZELAYOUT_TRIALFAILED  332
+#define IDS_OPTIMIZELAYOUT_NOFIT        333
 #define IDC_COMBO_FONT_RENDERER         1001
 #define IDC_COMBO_FONT                  1002
 #define IDC_COMBO_DIRECTWRITE_RENDERMODE 1004
@@ -320,6 +329,7 @@
 #define ID_EXPORT_MAPFONTCHNAXIS        40179
 #define ID_EXPORT_MAPFONTKRNAXIS        40180
 #define ID_EXPORT_MAPFONTTCAXIS 40189
+#define ID_EXPORT_OPTIMIZELAYOUT        40190
 #define ID_FILE_LANGUAGE                40181
 #define ID_LANGUAGE_ENGLISH             40182
 #define ID_LANGUAGE_KOREAN              40183
@@ -334,7 +344,7 @@
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        186
-#define _APS_NEXT_COMMAND_VALUE         40189
+#define _APS_NEXT_COMMAND_VALUE         40191
 #define _APS_NEXT_CONTROL_VALUE         1054
 #define _APS_NEXT_SYMED_VALUE           101
 #endif